@@ -1,312 +1,282 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <cctype>
-#include <algorithm>
-
-using std::string;
-
-/* -------------------- Utilities -------------------- */
-
-static inline bool is_all_digits(const string& s) {
-    for (char c : s) if (!std::isdigit(static_cast<unsigned char>(c))) return false;
-    return !s.empty();
-}
-
-static inline void trim_leading_zeros(string& s) {
-    size_t i = 0;
-    while (i + 1 < s.size() && s[i] == '0') ++i;
-    if (i > 0) s.erase(0, i);
-}
-
-static inline void trim_trailing_zeros(string& s) {
-    // for fractional part only
-    while (!s.empty() && s.back() == '0') s.pop_back();
-}
-
-/* -------------------- Validation -------------------- */
-/*
-   Valid double format (string only, no conversion):
-   Optional sign [+|-], then digits, optionally '.' with at least 1 digit on BOTH sides.
-   Allowed examples: "1", "1.0", "+1.0", "+0001.0", "-0001.005"
-   Disallowed examples: "A", "+-1", "-5.", "-.5", "-5.-5"
-*/
-bool is_valid_double_literal(const string& x) {
-    if (x.empty()) return false;
-
-    size_t i = 0;
-    if (x[i] == '+' || x[i] == '-') {
-        ++i;
-        if (i == x.size()) return false; // only sign is invalid
-    }
-
-    // must start with a digit now
-    if (i >= x.size() || !std::isdigit(static_cast<unsigned char>(x[i]))) return false;
-
-    // read integer digits
-    size_t j = i;
-    while (j < x.size() && std::isdigit(static_cast<unsigned char>(x[j]))) ++j;
-
-    if (j == x.size()) {
-        // pure integer
-        return true;
-    }
-
-    // if next char is '.', there must be at least one digit after it
-    if (x[j] == '.') {
-        size_t k = j + 1;
-        // at least one digit after '.'
-        if (k >= x.size()) return false;
-        if (!std::isdigit(static_cast<unsigned char>(x[k]))) return false;
-
-        while (k < x.size() && std::isdigit(static_cast<unsigned char>(x[k]))) ++k;
-        // nothing else allowed after fractional digits
-        return (k == x.size());
-    }
-
-    // anything else after integer digits is invalid
-    return false;
-}
-
-/* -------------------- BigDecimal (string-based) -------------------- */
-
-struct BigDecimal {
-    // sign: +1 or -1, zero uses +1 with "0" and empty frac.
-    int sign = +1;
-    string intPart = "0";   // no leading zeros except single "0"
-    string fracPart = "";   // no trailing zeros; empty means no decimal
-
-    bool isZero() const {
-        return intPart == "0" && fracPart.empty();
-    }
-};
-
-// Parse a validated literal into normalized BigDecimal.
-// Assumes is_valid_double_literal(x) == true.
-BigDecimal parse_normalize(const string& x) {
-    BigDecimal r;
-    size_t i = 0;
-
-    if (x[i] == '+') { r.sign = +1; ++i; }
-    else if (x[i] == '-') { r.sign = -1; ++i; }
-
-    // split on dot if present
-    size_t dot = x.find('.', i);
-    if (dot == string::npos) {
-        r.intPart = x.substr(i);
-        r.fracPart.clear();
-    } else {
-        r.intPart = x.substr(i, dot - i);
-        r.fracPart = x.substr(dot + 1);
-    }
-
-    // normalize integer part: remove leading zeros
-    trim_leading_zeros(r.intPart);
-    // normalize fractional part: remove trailing zeros
-    trim_trailing_zeros(r.fracPart);
-
-    // if all becomes zero -> sign should be + and represent canonical zero
-    if (r.intPart == "0" && r.fracPart.empty()) {
-        r.sign = +1;
-    }
-
-    return r;
-}
-
-// Align fractional lengths by padding right with zeros as needed
-static inline void align_frac(BigDecimal& a, BigDecimal& b) {
-    size_t L = std::max(a.fracPart.size(), b.fracPart.size());
-    a.fracPart.append(L - a.fracPart.size(), '0');
-    b.fracPart.append(L - b.fracPart.size(), '0');
-}
-
-// Compare |a| vs |b|. Return -1 if |a|<|b|, 0 if equal, +1 if |a|>|b|.
-int cmp_abs(BigDecimal a, BigDecimal b) {
-    align_frac(a, b);
-
-    // compare integer length
-    if (a.intPart.size() != b.intPart.size())
-        return (a.intPart.size() < b.intPart.size()) ? -1 : +1;
-
-    // compare integer lexicographically
-    if (a.intPart != b.intPart)
-        return (a.intPart < b.intPart) ? -1 : +1;
-
-    // compare fraction lexicographically
-    if (a.fracPart != b.fracPart)
-        return (a.fracPart < b.fracPart) ? -1 : +1;
-
-    return 0;
-}
-
-// Add absolute values: result is non-negative
-BigDecimal add_abs(BigDecimal a, BigDecimal b) {
-    align_frac(a, b);
-    BigDecimal r;
-    r.sign = +1;
-
-    // add fractional part
-    int carry = 0;
-    r.fracPart.resize(a.fracPart.size());
-    for (int i = static_cast<int>(a.fracPart.size()) - 1; i >= 0; --i) {
-        int da = a.fracPart[i] - '0';
-        int db = b.fracPart[i] - '0';
-        int s = da + db + carry;
-        r.fracPart[i] = char('0' + (s % 10));
-        carry = s / 10;
-    }
-    trim_trailing_zeros(r.fracPart);
-
-    // add integer part
-    string A = a.intPart, B = b.intPart;
-    // left-pad shorter integer with zeros
-    if (A.size() < B.size()) A.insert(0, B.size() - A.size(), '0');
-    if (B.size() < A.size()) B.insert(0, A.size() - B.size(), '0');
-
-    string s(A.size(), '0');
-    for (int i = static_cast<int>(A.size()) - 1; i >= 0; --i) {
-        int da = A[i] - '0';
-        int db = B[i] - '0';
-        int sum = da + db + carry;
-        s[i] = char('0' + (sum % 10));
-        carry = sum / 10;
-    }
-    if (carry) s.insert(s.begin(), char('0' + carry));
-
-    // normalize intPart
-    r.intPart = s;
-    trim_leading_zeros(r.intPart);
-
-    return r;
-}
-
-// Subtract absolute values: assumes |a| >= |b|. Returns non-negative result = |a|-|b|.
-BigDecimal sub_abs(BigDecimal a, BigDecimal b) {
-    align_frac(a, b);
-    BigDecimal r;
-    r.sign = +1;
-
-    // subtract fractional part
-    int borrow = 0;
-    r.fracPart.resize(a.fracPart.size());
-    for (int i = static_cast<int>(a.fracPart.size()) - 1; i >= 0; --i) {
-        int da = a.fracPart[i] - '0' - borrow;
-        int db = b.fracPart[i] - '0';
-        if (da < db) { da += 10; borrow = 1; } else borrow = 0;
-        r.fracPart[i] = char('0' + (da - db));
-    }
-    trim_trailing_zeros(r.fracPart);
-
-    // subtract integer part
-    string A = a.intPart, B = b.intPart;
-    if (A.size() < B.size()) A.insert(0, B.size() - A.size(), '0');
-    if (B.size() < A.size()) B.insert(0, A.size() - B.size(), '0');
-
-    string s(A.size(), '0');
-    for (int i = static_cast<int>(A.size()) - 1; i >= 0; --i) {
-        int da = A[i] - '0' - borrow;
-        int db = B[i] - '0';
-        if (da < db) { da += 10; borrow = 1; } else borrow = 0;
-        s[i] = char('0' + (da - db));
-    }
-
-    // remove leading zeros
-    trim_leading_zeros(s);
-    if (s == "0" && r.fracPart.empty()) {
-        r.sign = +1;
-        r.intPart = "0";
-    } else {
-        r.intPart = s;
-    }
-    return r;
-}
-
-// a + b (with signs)
-BigDecimal add_signed(BigDecimal a, BigDecimal b) {
-    if (a.isZero()) return b;
-    if (b.isZero()) return a;
-
-    if (a.sign == b.sign) {
-        BigDecimal r = add_abs(a, b);
-        r.sign = a.sign;
-        if (r.isZero()) r.sign = +1;
-        return r;
-    } else {
-        // opposite signs => subtraction by larger magnitude
-        int cmp = cmp_abs(a, b);
-        if (cmp == 0) {
-            return BigDecimal{+1, "0", ""};
-        } else if (cmp > 0) {
-            BigDecimal r = sub_abs(a, b);
-            r.sign = a.sign;
-            if (r.isZero()) r.sign = +1;
-            return r;
-        } else {
-            BigDecimal r = sub_abs(b, a);
-            r.sign = b.sign;
-            if (r.isZero()) r.sign = +1;
-            return r;
-        }
-    }
-}
-
-string to_string(const BigDecimal& x) {
-    if (x.isZero()) return "0";
-    string out;
-    if (x.sign < 0) out.push_back('-');
-    out += x.intPart;
-    if (!x.fracPart.empty()) {
-        out.push_back('.');
-        out += x.fracPart;
-    }
-    return out;
-}
-
-/* -------------------- I/O & Driver -------------------- */
-
-int main() {
-    std::ios::sync_with_stdio(false);
-    std::cin.tie(nullptr);
-
-    std::cout << "Enter input file name: ";
-    std::string filename;
-    if (!(std::cin >> filename)) {
-        std::cerr << "Failed to read file name.\n";
-        return 1;
-    }
-
-    std::ifstream fin(filename);
-    if (!fin) {
-        std::cerr << "Error: could not open file '" << filename << "'.\n";
-        return 1;
-    }
-
-    std::cout << "Processing test cases from '" << filename << "'...\n\n";
-
-    string a, b;
-    int lineNo = 0;
-    while (fin >> a >> b) {
-        ++lineNo;
-        bool okA = is_valid_double_literal(a);
-        bool okB = is_valid_double_literal(b);
-
-        std::cout << "Case " << lineNo << ": " << a << " + " << b << "\n";
-        if (!okA) {
-            std::cout << "  -> INVALID: '" << a << "' is not a valid double literal.\n\n";
-            continue;
-        }
-        if (!okB) {
-            std::cout << "  -> INVALID: '" << b << "' is not a valid double literal.\n\n";
-            continue;
-        }
-
-        BigDecimal A = parse_normalize(a);
-        BigDecimal B = parse_normalize(b);
-        BigDecimal S = add_signed(A, B);
-
-        std::cout << "  -> " << to_string(A) << " + " << to_string(B)
-                  << " = " << to_string(S) << "\n\n";
-    }
-
-    return 0;
-}
+#include "driver.h"
+
+#include <iostream>
+#include <string>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace calc;
+
+/* -------------------- Utilities -------------------- */
+
+static inline bool is_all_digits(const string& s) {
+    for (char c : s) if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+    return !s.empty();
+}
+
+#ifdef CALC_STATS
+// Every call to the global operator new, from any thread.
+static std::atomic<uint64_t> stats_allocs{0}, stats_alloc_bytes{0};
+
+void* operator new(size_t n) {
+    stats_allocs.fetch_add(1, std::memory_order_relaxed);
+    stats_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+// kept out of line: inlined into a caller, GCC flags free() on a new'd pointer
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// --stats: everything counted so far, as one line of JSON on stderr.
+static void print_stats() {
+    Stats t = stats_snapshot();
+    DriverStats d = driver_stats_snapshot();
+
+    string j;
+    auto field = [&](const char* name, uint64_t v) {
+        if (j.back() != '{') j += ',';
+        j += '"';
+        j += name;
+        j += "\":";
+        append_uint(j, v);
+    };
+    j += '{';
+    field("bytes_read", d.bytesRead);
+    field("bytes_written", d.bytesWritten);
+    field("tokens", t.tokens);
+    j += ",\"rejected\":{";
+    field("empty", t.rejected[size_t(ParseError::Empty)]);
+    field("sign_only", t.rejected[size_t(ParseError::SignOnly)]);
+    field("no_int_digits", t.rejected[size_t(ParseError::NoIntDigits)]);
+    field("no_frac_digits", t.rejected[size_t(ParseError::NoFracDigits)]);
+    field("bad_char", t.rejected[size_t(ParseError::BadChar)]);
+    j += "},\"literal_length_log2\":[";
+    size_t n = 32;
+    while (n > 1 && t.lengthLog2[n - 1] == 0) --n;
+    for (size_t i = 0; i < n; ++i) {
+        if (i) j += ',';
+        append_uint(j, t.lengthLog2[i]);
+    }
+    j += "],\"time_ns\":{";
+    field("parse", d.parseNs);
+    field("compute", d.computeNs);
+    field("format", d.formatNs);
+    field("write", d.writeNs);
+    j += "},\"allocations\":{";
+    field("count", stats_allocs.load());
+    field("bytes", stats_alloc_bytes.load());
+    field("limb_spills", t.limbSpills);
+    j += "},\"cache\":{";
+    field("hits", d.cacheHits);
+    field("misses", d.cacheMisses);
+    j += "}}\n";
+    std::cerr << j;
+}
+#endif
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--sum] [-j N] [--pipeline] [--format F] [--op add|mul|div]\n"
+              << "       [--precision DIGITS] [--rounding half-even|half-up|truncate] [--cache]\n"
+              << "       [--cache-file PATH] [--scale I.F] [--stats] [FILE|-]...\n"
+              << "With no FILE, asks for a file name; '-' reads standard input.\n"
+              << "--pipeline reads, computes and writes on separate threads (-j takes precedence\n"
+              << "for regular files).\n"
+              << "--scale I.F adds values with at most I integer and F fractional digits on a\n"
+              << "fixed-point fast path (others still work, just not on it).\n"
+              << "--cache remembers results worked out on limbs (wide mul and div, rounded sums);\n"
+              << "plain sums, results that fit 128 bits and --format binary never use it.\n"
+              << "--cache-file PATH keeps them in PATH across runs (one process at a time).\n"
+              << "Results are exact unless --precision is given; div defaults to "
+              << DIV_DEFAULT_PRECISION << " digits.\n";
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    bool sumMode = false;
+    unsigned threads = 1;
+    PairOptions opt;
+    bool opSet = false;
+    bool stats = false;
+    bool pipeline = false;
+    bool useCache = false;
+    string scale;  // --scale I.F
+    string cachePath;  // empty: in memory only
+    std::vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--sum") {
+            sumMode = true;
+        } else if (arg == "--pipeline") {
+            pipeline = true;
+        } else if (arg == "--scale" && i + 1 < argc) {
+            scale = argv[++i];
+        } else if (arg == "--cache") {
+            useCache = true;
+        } else if (arg == "--cache-file" && i + 1 < argc) {
+            useCache = true;
+            cachePath = argv[++i];
+        } else if (arg == "--stats") {
+#ifndef CALC_STATS
+            std::cerr << "Error: --stats needs a build with -DCALC_STATS (make calc-stats).\n";
+            return 1;
+#endif
+            stats = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            string f = argv[++i];
+            if (f == "human") opt.fmt = OutputFormat::Human;
+            else if (f == "sum-only") opt.fmt = OutputFormat::SumOnly;
+            else if (f == "tsv") opt.fmt = OutputFormat::Tsv;
+            else if (f == "binary") opt.fmt = OutputFormat::Binary;
+            else {
+                std::cerr << "Error: unknown format '" << f << "' (human, sum-only, tsv, binary).\n";
+                return 1;
+            }
+        } else if (arg == "--op" && i + 1 < argc) {
+            string o = argv[++i];
+            if (o == "add") opt.op = PairOp::Add;
+            else if (o == "mul") opt.op = PairOp::Mul;
+            else if (o == "div") opt.op = PairOp::Div;
+            else {
+                std::cerr << "Error: unknown operation '" << o << "' (add, mul, div).\n";
+                return 1;
+            }
+            opSet = true;
+        } else if (arg == "--precision" && i + 1 < argc) {
+            string n = argv[++i];
+            if (!is_all_digits(n) || n.size() > 9) {
+                std::cerr << "Error: --precision needs a number of fractional digits.\n";
+                return 1;
+            }
+            opt.ctx.precision = std::stoul(n);
+        } else if (arg == "--rounding" && i + 1 < argc) {
+            string m = argv[++i];
+            if (m == "half-even") opt.ctx.rounding = RoundingMode::HalfEven;
+            else if (m == "half-up") opt.ctx.rounding = RoundingMode::HalfUp;
+            else if (m == "truncate") opt.ctx.rounding = RoundingMode::Truncate;
+            else {
+                std::cerr << "Error: unknown rounding '" << m << "' (half-even, half-up, truncate).\n";
+                return 1;
+            }
+        } else if (arg.compare(0, 2, "-j") == 0 && (arg.size() > 2 || i + 1 < argc)) {
+            string n = arg.size() > 2 ? arg.substr(2) : string(argv[++i]);
+            if (!is_all_digits(n) || n.size() > 9 || std::stoul(n) == 0) {
+                std::cerr << "Error: -j needs a positive thread count.\n";
+                return 1;
+            }
+            threads = unsigned(std::min<unsigned long>(std::stoul(n), 1024));
+        } else if (arg == "-" || arg.empty() || arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (sumMode && (opt.fmt != OutputFormat::Human || opSet || useCache || !scale.empty())) {
+        std::cerr << "Error: --format, --op, --cache and --scale apply to pair mode only.\n";
+        return 1;
+    }
+    if (!scale.empty()) {
+        size_t dot = scale.find('.');
+        string si = scale.substr(0, dot), sf = dot == string::npos ? "" : scale.substr(dot + 1);
+        FixedBatchFn fn = nullptr;
+        if (is_all_digits(si) && is_all_digits(sf) && si.size() <= 2 && sf.size() <= 2)
+            fn = fixed_batch_for(unsigned(std::stoul(si)), unsigned(std::stoul(sf)));
+        if (!fn) {
+            std::cerr << "Error: --scale needs I.F with I + F <= 37 and F <= " << FIXED_MAX_FRAC << ".\n";
+            return 1;
+        }
+        if (opt.op != PairOp::Add) {
+            std::cerr << "Error: --scale applies to --op add only.\n";
+            return 1;
+        }
+        // binary records and rounded sums need limbs; those cases skip the fixed path
+        if (opt.fmt != OutputFormat::Binary && std::stoul(sf) <= opt.ctx.precision) opt.fixedBatch = fn;
+    }
+    ResultCache cache;
+    if (useCache) {
+        if (!cache.open(cachePath)) {
+            if (cachePath.empty()) std::cerr << "Error: could not set up the result cache.\n";
+            else if (errno == EWOULDBLOCK)
+                std::cerr << "Error: cache file '" << cachePath << "' is in use by another process.\n";
+            else std::cerr << "Error: could not open cache file '" << cachePath << "'.\n";
+            return 1;
+        }
+        opt.cache = &cache;
+    }
+    bool human = opt.fmt == OutputFormat::Human;
+    opt.threads = threads;
+
+    if (files.empty()) {
+        // interactive use: machine-readable output must not start with the prompt
+        (human ? std::cout : std::cerr) << "Enter input file name: " << std::flush;
+        std::string filename;
+        if (!(std::cin >> filename)) {
+            std::cerr << "Failed to read file name.\n";
+            return 1;
+        }
+        files.push_back(filename);
+    }
+
+    OutputSink sink;
+    BigDecimalAccumulator total;  // --sum: one total over every input
+    unsigned long long invalid = 0;
+    int status = 0;
+
+    for (const string& filename : files) {
+        InputReader fin;
+        if (!fin.open(filename)) {
+            sink.flush();
+            std::cerr << "Error: could not open file '" << filename << "'.\n";
+            status = 1;
+            continue;
+        }
+
+        std::string_view whole = fin.mapped();
+        bool parallel = threads > 1 && !whole.empty();  // streams cannot be split up front
+
+        if (sumMode) {
+            if (parallel) run_sum_parallel(whole, threads, total, invalid);
+            else if (pipeline) run_sum_pipelined(fin, total, invalid);
+            else run_sum(fin, total, invalid);
+            continue;
+        }
+
+        if (human) {
+            string& out = sink.buffer();
+            out += "Processing test cases from '";
+            out += filename;
+            out += "'...\n\n";
+        }
+        if (parallel) run_pairs_parallel(whole, threads, sink, opt);
+        else if (pipeline) run_pairs_pipelined(fin, sink, opt);
+        else run_pairs(fin, sink, opt);
+    }
+
+    if (sumMode) {
+        // the total is exact until here, so it is rounded only once
+        BigDecimal t = total.finish();
+        round_to(t, opt.ctx.precision, opt.ctx.rounding);
+        print_total(sink, t, invalid);
+    }
+    sink.flush();  // so the last write is counted, and its error seen
+    if (sink.error()) {
+        std::cerr << "Error: could not write the output (" << std::strerror(sink.error()) << ").\n";
+        status = 1;
+    }
+    if (stats) {
+#ifdef CALC_STATS
+        print_stats();
+#endif
+    }
+    return status;
+}
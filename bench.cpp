@@ -0,0 +1,496 @@
+// Microbenchmarks for the arithmetic core plus end-to-end file throughput.
+// Build with `make bench` (needs Google Benchmark); run ./bench.
+// ./bench --save-baseline=FILE and --gate=FILE guard end-to-end throughput
+// (make baseline / make gate); the differential check is check.cpp.
+
+#include "bigdecimal.h"
+#include "driver.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace bigdecimal;
+using namespace calc;
+
+/* -------------------- Inputs -------------------- */
+
+// n-digit literal (no leading/trailing zeros); with `frac` about a third of
+// the digits go after the dot.
+static string make_literal(size_t n, bool frac, bool negative, uint32_t seed) {
+    std::mt19937 rng(seed);
+    string s = negative ? "-" : "";
+    size_t fracDigits = (frac && n >= 2) ? std::max<size_t>(1, n / 3) : 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i == n - fracDigits) s.push_back('.');
+        char c = char('0' + rng() % 10);
+        if ((i == 0 || i == n - 1) && c == '0') c = '7';
+        s.push_back(c);
+    }
+    return s;
+}
+
+// lengths 1 .. 1M digits, each with and without a fraction
+static void digit_args(benchmark::internal::Benchmark* b) {
+    for (int64_t n = 1; n <= (1 << 20); n *= 8) {
+        b->Args({n, 0});
+        b->Args({n, 1});
+    }
+    b->Args({1 << 20, 0});
+    b->Args({1 << 20, 1});
+}
+
+// as above, plus operand signs: 0 = same, 1 = mixed
+static void signed_args(benchmark::internal::Benchmark* b) {
+    for (int64_t n = 1; n <= (1 << 20); n *= 8)
+        for (int64_t f = 0; f <= 1; ++f)
+            for (int64_t m = 0; m <= 1; ++m) b->Args({n, f, m});
+    for (int64_t f = 0; f <= 1; ++f)
+        for (int64_t m = 0; m <= 1; ++m) b->Args({1 << 20, f, m});
+}
+
+/* -------------------- Core -------------------- */
+
+static void BM_is_valid_double_literal(benchmark::State& state) {
+    string x = make_literal(size_t(state.range(0)), state.range(1) != 0, true, 1);
+    for (auto _ : state) benchmark::DoNotOptimize(is_valid_double_literal(x));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(x.size()));
+}
+BENCHMARK(BM_is_valid_double_literal)->Apply(digit_args);
+
+static void BM_parse_normalize(benchmark::State& state) {
+    string x = make_literal(size_t(state.range(0)), state.range(1) != 0, true, 2);
+    for (auto _ : state) benchmark::DoNotOptimize(parse_normalize(x));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(x.size()));
+}
+BENCHMARK(BM_parse_normalize)->Apply(digit_args);
+
+static void BM_cmp_abs(benchmark::State& state) {
+    // equal up to the last digit: the full-length case
+    string x = make_literal(size_t(state.range(0)), state.range(1) != 0, false, 3);
+    string y = x;
+    y.back() = (y.back() == '9') ? '8' : char(y.back() + 1);
+    BigDecimal a = parse_normalize(x), b = parse_normalize(y);
+    for (auto _ : state) benchmark::DoNotOptimize(cmp_abs(a, b));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(x.size()));
+}
+BENCHMARK(BM_cmp_abs)->Apply(digit_args);
+
+static void BM_add_abs(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    bool f = state.range(1) != 0;
+    BigDecimal a = parse_normalize(make_literal(n, f, false, 4));
+    BigDecimal b = parse_normalize(make_literal(n, f, false, 5));
+    for (auto _ : state) benchmark::DoNotOptimize(add_abs(a, b));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_add_abs)->Apply(digit_args);
+
+static void BM_sub_abs(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    bool f = state.range(1) != 0;
+    BigDecimal a = parse_normalize(make_literal(n, f, false, 6));
+    BigDecimal b = parse_normalize(make_literal(n, f, false, 7));
+    if (cmp_abs(a, b) < 0) std::swap(a, b);
+    for (auto _ : state) benchmark::DoNotOptimize(sub_abs(a, b));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_sub_abs)->Apply(digit_args);
+
+// Operands equal but for their last 18 digits: the compare runs the whole
+// length, the subtraction only the limbs below the shared top.
+static void BM_sub_abs_close(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    string x = make_literal(n, state.range(1) != 0, false, 6);
+    string y = x.substr(0, x.size() - std::min<size_t>(18, x.size() - 1)) + make_literal(18, false, false, 7);
+    y.resize(x.size());
+    BigDecimal a = parse_normalize(x), b = parse_normalize(y);
+    for (auto _ : state) benchmark::DoNotOptimize(sub_abs(a, b));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_sub_abs_close)->Apply(digit_args);
+
+static void BM_add_signed(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    bool f = state.range(1) != 0;
+    BigDecimal a = parse_normalize(make_literal(n, f, false, 8));
+    BigDecimal b = parse_normalize(make_literal(n, f, state.range(2) != 0, 9));
+    for (auto _ : state) benchmark::DoNotOptimize(add_signed(a, b));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_add_signed)->Apply(signed_args);
+
+// The 128-bit path on the same operands as BM_add_signed (up to 38 digits);
+// the difference between the two rows is what run_case saves per case.
+static void BM_add_small(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    bool f = state.range(1) != 0;
+    SmallDecimal a, b, r;
+    assign(a, make_view(make_literal(n, f, false, 8)));
+    assign(b, make_view(make_literal(n, f, state.range(2) != 0, 9)));
+    for (auto _ : state) {
+        add_small(a, b, r);
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_add_small)->ArgsProduct({{1, 8, 18, 37}, {0, 1}, {0, 1}});
+
+// Text in, text out for one wide sum: through limbs (arg 2 = 0, what
+// run_case did before the digit path) or straight on the digits (1).
+static void BM_add_text(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    string a = make_literal(n, true, false, 8);
+    string b = make_literal(n, true, state.range(1) != 0, 9);
+    BigDecimalView va = make_view(a), vb = make_view(b);
+    BigDecimal A, B, S;
+    string buf, pad, out;
+    for (auto _ : state) {
+        out.clear();
+        if (state.range(2)) {
+            to_string(add_views(va, vb, buf, pad), out);
+        } else {
+            assign(A, va);
+            assign(B, vb);
+            copy_widened(S, A, B.frac);
+            add_into(S, B, 1);
+            to_string(S, out);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_add_text)->ArgsProduct({{40, 128, 1024, 16384, 1 << 17}, {0, 1}, {0, 1}});
+
+// One block of sum-only cases in an I.F schema (first two arguments), case
+// by case through run_case or, with the third argument, --scale's batch adder.
+static void BM_add_fixed(benchmark::State& state) {
+    unsigned i = unsigned(state.range(0)), f = unsigned(state.range(1));
+    std::mt19937 rng(10);
+    auto digits = [&](unsigned n) {
+        string s;
+        for (unsigned k = 0; k < n; ++k) s.push_back(char('0' + rng() % 10));
+        return s;
+    };
+    std::vector<string> text;
+    for (size_t k = 0; k < 2 * FIXED_BATCH; ++k)
+        text.push_back((rng() % 2 ? "-" : "") + digits(i) + (f ? "." + digits(f) : ""));
+    std::vector<std::string_view> tok(text.begin(), text.end());
+    PairOptions opt;
+    opt.fmt = OutputFormat::SumOnly;
+    if (state.range(2)) opt.fixedBatch = fixed_batch_for(i, f);
+    CaseBuffers bufs;
+    string out;
+    for (auto _ : state) {
+        out.clear();
+        if (opt.fixedBatch) opt.fixedBatch(out, opt, 0, tok.data(), FIXED_BATCH, bufs);
+        else
+            for (size_t k = 0; k < FIXED_BATCH; ++k)
+                run_case(out, opt, static_cast<long long>(k + 1), tok[2 * k], tok[2 * k + 1], bufs);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(FIXED_BATCH));
+}
+BENCHMARK(BM_add_fixed)->ArgsProduct({{10, 20, 30}, {4}, {0, 1}})->Args({3, 0, 0})->Args({3, 0, 1});
+
+// 1024 mixed-sign pairs of n-digit views into one buffer: 0 calls add_signed
+// per pair, 1 add_views per pair, 2 is a single add_batch.
+static void BM_add_batch(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<string> text;
+    for (uint32_t k = 0; k < 2048; ++k) text.push_back(make_literal(n, true, k % 3 == 0, k));
+    std::vector<BigDecimalView> va, vb;
+    for (size_t k = 0; k < text.size(); k += 2) {
+        va.push_back(make_view(text[k]));
+        vb.push_back(make_view(text[k + 1]));
+    }
+    BigDecimal A, B;
+    string buf, pad;
+    OutputBuffer out;
+    for (auto _ : state) {
+        if (state.range(1) == 2) {
+            add_batch(va, vb, out);
+        } else {
+            out.text.clear();
+            out.offsets.clear();
+            for (size_t k = 0; k < va.size(); ++k) {
+                out.offsets.push_back(out.text.size());
+                if (state.range(1) == 1) {
+                    to_string(add_views(va[k], vb[k], buf, pad), out.text);
+                } else {
+                    assign(A, va[k]);
+                    assign(B, vb[k]);
+                    to_string(add_signed(A, B), out.text);
+                }
+            }
+            out.offsets.push_back(out.text.size());
+        }
+        benchmark::DoNotOptimize(out.text.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(va.size()));
+}
+BENCHMARK(BM_add_batch)->ArgsProduct({{8, 20, 40, 128, 1024}, {0, 1, 2}});
+
+// One huge addition split over threads (1 = the serial loop); the third
+// argument mixes signs so the borrow chain runs. Sizes are in digits; the
+// smallest where a thread count beats its 1-thread row, divided by 9, is
+// the par_add_threshold (in limbs) to use.
+static void BM_add_parallel(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    unsigned threads = unsigned(state.range(1));
+    BigDecimal a = parse_normalize(make_literal(n, true, false, 8));
+    BigDecimal b = parse_normalize(make_literal(n, true, state.range(2) != 0, 9));
+    size_t saved = par_add_threshold;
+    par_add_threshold = 0;
+    BigDecimal r;
+    for (auto _ : state) {
+        r = a;
+        add_into(r, b, threads);
+        benchmark::DoNotOptimize(r.limbs.data());
+    }
+    par_add_threshold = saved;
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_add_parallel)
+    ->ArgsProduct({{1 << 15, 1 << 17, 1 << 19, 1 << 21, 1 << 23}, {1, 2, 4, 8}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Multiplication by algorithm: the second argument pins the crossovers so a
+// single method runs (0 schoolbook, 1 Karatsuba, 2 Toom-3, 3 NTT) or, with 4,
+// keeps the current mul_thresholds. Compare the rows to retune them.
+static void BM_mul(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    BigDecimal a = parse_normalize(make_literal(n, false, false, 11));
+    BigDecimal b = parse_normalize(make_literal(n, false, true, 12));
+    const size_t never = SIZE_MAX;
+    MulThresholds saved = mul_thresholds;
+    switch (state.range(1)) {
+    case 0: mul_thresholds = {never, never, never}; break;
+    case 1: mul_thresholds = {saved.karatsuba, never, never}; break;
+    case 2: mul_thresholds = {saved.karatsuba, saved.karatsuba, never}; break;
+    case 3: mul_thresholds = {saved.karatsuba, saved.karatsuba, 0}; break;
+    default: break;
+    }
+    for (auto _ : state) benchmark::DoNotOptimize(mul(a, b));
+    mul_thresholds = saved;
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_mul)->ArgsProduct({{9, 90, 360, 1440, 5760, 11520, 23040, 46080}, {0, 1, 2, 3, 4}});
+BENCHMARK(BM_mul)->ArgsProduct({{184320, 1 << 20}, {3, 4}});
+
+// Division of a 2n-digit by an n-digit value to 18 places; the second
+// argument forces Knuth D (0), Newton-Raphson (1) or div_newton_threshold (2).
+static void BM_div(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    BigDecimal a = parse_normalize(make_literal(2 * n, false, false, 13));
+    BigDecimal b = parse_normalize(make_literal(n, true, true, 14));
+    size_t saved = div_newton_threshold;
+    if (state.range(1) == 0) div_newton_threshold = SIZE_MAX;
+    if (state.range(1) == 1) div_newton_threshold = 2;
+    for (auto _ : state) benchmark::DoNotOptimize(div(a, b, 18, RoundingMode::HalfEven));
+    div_newton_threshold = saved;
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+BENCHMARK(BM_div)->ArgsProduct({{90, 900, 3600, 14400, 57600, 115200}, {0, 1, 2}})->Unit(benchmark::kMicrosecond);
+
+static void BM_to_string(benchmark::State& state) {
+    BigDecimal a = parse_normalize(make_literal(size_t(state.range(0)), state.range(1) != 0, true, 10));
+    for (auto _ : state) benchmark::DoNotOptimize(to_string(a));
+    state.SetItemsProcessed(int64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_to_string)->Apply(digit_args);
+
+/* -------------------- End to end -------------------- */
+
+// ~16 MB pair file of mostly short, mixed-sign operands with a few long ones
+static const string& corpus_path() {
+    static const string path = [] {
+        char tmpl[] = "/tmp/calc_bench_XXXXXX";
+        int fd = mkstemp(tmpl);
+        if (fd >= 0) ::close(fd);
+        std::mt19937 rng(42);
+        std::ofstream out(tmpl);
+        size_t bytes = 0;
+        while (bytes < (size_t(16) << 20)) {
+            size_t n = (rng() % 64 == 0) ? 1 + rng() % 4096 : 1 + rng() % 30;
+            string a = make_literal(n, rng() % 2, rng() % 2, rng());
+            string b = make_literal(1 + rng() % 30, rng() % 2, rng() % 2, rng());
+            out << a << ' ' << b << '\n';
+            bytes += a.size() + b.size() + 2;
+        }
+        return string(tmpl);
+    }();
+    return path;
+}
+
+// Throughput of a whole run, output discarded; reported as bytes/second.
+template <class Run>
+static void run_file(benchmark::State& state, Run run) {
+    const string& path = corpus_path();
+    int null = ::open("/dev/null", O_WRONLY);
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        InputReader in;
+        if (!in.open(path)) { state.SkipWithError("cannot open corpus"); break; }
+        bytes += int64_t(in.mapped().size());
+        OutputSink sink(null);
+        run(in, sink);
+    }
+    ::close(null);
+    state.SetBytesProcessed(bytes);
+}
+
+static void BM_file_pairs(benchmark::State& state) {
+    run_file(state, [](InputReader& in, OutputSink& sink) { run_pairs(in, sink, PairOptions{}); });
+}
+BENCHMARK(BM_file_pairs)->Unit(benchmark::kMillisecond);
+
+static void BM_file_sum(benchmark::State& state) {
+    run_file(state, [](InputReader& in, OutputSink& sink) {
+        BigDecimalAccumulator total;
+        unsigned long long invalid = 0;
+        run_sum(in, total, invalid);
+        print_total(sink, total.finish(), invalid);
+    });
+}
+BENCHMARK(BM_file_sum)->Unit(benchmark::kMillisecond);
+
+// --pipeline variants: reader, compute and writer threads
+static void BM_file_pairs_pipelined(benchmark::State& state) {
+    run_file(state, [](InputReader& in, OutputSink& sink) { run_pairs_pipelined(in, sink, PairOptions{}); });
+}
+BENCHMARK(BM_file_pairs_pipelined)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_file_sum_pipelined(benchmark::State& state) {
+    run_file(state, [](InputReader& in, OutputSink& sink) {
+        BigDecimalAccumulator total;
+        unsigned long long invalid = 0;
+        run_sum_pipelined(in, total, invalid);
+        print_total(sink, total.finish(), invalid);
+    });
+}
+BENCHMARK(BM_file_sum_pipelined)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// -j N variants; the argument is the thread count
+static void BM_file_pairs_parallel(benchmark::State& state) {
+    unsigned threads = unsigned(state.range(0));
+    run_file(state, [threads](InputReader& in, OutputSink& sink) {
+        run_pairs_parallel(in.mapped(), threads, sink, PairOptions{});
+    });
+}
+BENCHMARK(BM_file_pairs_parallel)->RangeMultiplier(2)->Range(2, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_file_sum_parallel(benchmark::State& state) {
+    unsigned threads = unsigned(state.range(0));
+    run_file(state, [threads](InputReader& in, OutputSink& sink) {
+        BigDecimalAccumulator total;
+        unsigned long long invalid = 0;
+        run_sum_parallel(in.mapped(), threads, total, invalid);
+        print_total(sink, total.finish(), invalid);
+    });
+}
+BENCHMARK(BM_file_sum_parallel)->RangeMultiplier(2)->Range(2, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/* -------------------- Throughput gate (--gate) -------------------- */
+/*
+   The end-to-end runs on the standard corpus, GATE_REPS times each, keeping
+   the best bytes/second per benchmark: load on the box only ever slows a
+   run down, so the fastest repetition is the steadiest figure.
+   --save-baseline=FILE records them as "name bytes_per_second" lines, and
+   --gate=FILE fails when any of them comes in more than GATE_DROP below
+   its recorded value.
+*/
+
+constexpr double GATE_DROP = 0.05;
+constexpr const char* GATE_FILTER = "^BM_file_(pairs|sum)(_pipelined)?(/real_time)?$";
+constexpr int GATE_REPS = 5;
+
+class BestReporter : public benchmark::ConsoleReporter {
+public:
+    std::vector<std::pair<string, double>> best;  // in the order they ran
+
+    void ReportRuns(const std::vector<Run>& runs) override {
+        ConsoleReporter::ReportRuns(runs);
+        for (const Run& r : runs) {
+            auto c = r.counters.find("bytes_per_second");
+            if (r.run_type != Run::RT_Iteration || c == r.counters.end()) continue;
+            string name = r.run_name.function_name;
+            if (best.empty() || best.back().first != name) best.emplace_back(name, 0.0);
+            best.back().second = std::max(best.back().second, double(c->second));
+        }
+    }
+};
+
+static int run_gate(const string& baseline, bool save) {
+    BestReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    if (reporter.best.empty()) {
+        std::fprintf(stderr, "gate: no benchmark ran\n");
+        return 1;
+    }
+    if (save) {
+        std::ofstream out(baseline);
+        for (auto& m : reporter.best) out << m.first << ' ' << std::fixed << m.second << '\n';
+        if (!out) {
+            std::fprintf(stderr, "gate: cannot write '%s'\n", baseline.c_str());
+            return 1;
+        }
+        std::printf("gate: baseline saved to %s\n", baseline.c_str());
+        return 0;
+    }
+
+    std::ifstream in(baseline);
+    if (!in) {
+        std::fprintf(stderr, "gate: cannot read '%s' (record one with --save-baseline)\n", baseline.c_str());
+        return 1;
+    }
+    std::vector<std::pair<string, double>> base;
+    string name;
+    double v;
+    while (in >> name >> v) base.emplace_back(name, v);
+
+    int failed = 0;
+    for (auto& m : reporter.best) {
+        auto b = std::find_if(base.begin(), base.end(), [&](auto& e) { return e.first == m.first; });
+        if (b == base.end()) {
+            std::printf("gate: %-28s no baseline\n", m.first.c_str());
+            continue;
+        }
+        double change = m.second / b->second - 1;
+        bool slow = change < -GATE_DROP;
+        failed += slow;
+        std::printf("gate: %-28s %+6.1f%%%s\n", m.first.c_str(), 100 * change, slow ? "  FAIL" : "");
+    }
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    // our own flags; the rest go to Google Benchmark
+    bool save = false;
+    string baseline;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        string a = argv[i];
+        if (a.rfind("--gate=", 0) == 0) baseline = a.substr(7);
+        else if (a.rfind("--save-baseline=", 0) == 0) { baseline = a.substr(16); save = true; }
+        else args.push_back(argv[i]);
+    }
+    string filter = string("--benchmark_filter=") + GATE_FILTER;
+    string reps = "--benchmark_repetitions=" + std::to_string(GATE_REPS);
+    if (!baseline.empty()) {
+        // flags given on the command line come later and win
+        args.insert(args.begin() + 1, {&filter[0], &reps[0]});
+    }
+    int n = int(args.size());
+    benchmark::Initialize(&n, args.data());
+    if (benchmark::ReportUnrecognizedArguments(n, args.data())) return 1;
+    int status = 0;
+    if (!baseline.empty()) status = run_gate(baseline, save);
+    else benchmark::RunSpecifiedBenchmarks();
+    std::remove(corpus_path().c_str());
+    return status;
+}
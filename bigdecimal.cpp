@@ -0,0 +1,1684 @@
+// The BigDecimal core declared in bigdecimal.h.
+#include "bigdecimal.h"
+#include "parallel.h"
+
+#include <cctype>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace bigdecimal {
+
+using std::string;
+
+/* -------------------- Digit scanning kernels -------------------- */
+/*
+   first_non_digit(p, n) returns the offset of the first byte in [p, p+n)
+   that is not '0'..'9' (n if there is none). The vector kernels classify a
+   whole block per step and finish the tail with the scalar loop; the best
+   one for the running CPU is picked once, on first use.
+*/
+
+static size_t first_non_digit_scalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && std::isdigit(static_cast<unsigned char>(p[i]))) ++i;
+    return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static size_t first_non_digit_avx2(const char* p, size_t n) {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), zero);
+        // digit <=> (c - '0') <= 9 unsigned <=> max(c - '0', 9) == 9
+        __m256i ok = _mm256_cmpeq_epi8(_mm256_max_epu8(v, nine), nine);
+        uint32_t bad = ~uint32_t(_mm256_movemask_epi8(ok));
+        if (bad) return i + size_t(__builtin_ctz(bad));
+    }
+    return i + first_non_digit_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+static size_t first_non_digit_sse42(const char* p, size_t n) {
+    // pcmpestri in range mode, negated: index of the first byte outside '0'..'9'
+    const __m128i range = _mm_setr_epi8('0', '9', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int idx = _mm_cmpestri(range, 2, v, 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_NEGATIVE_POLARITY);
+        if (idx < 16) return i + size_t(idx);
+    }
+    return i + first_non_digit_scalar(p + i, n - i);
+}
+
+#elif defined(__ARM_NEON)
+
+static size_t first_non_digit_neon(const char* p, size_t n) {
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t ten = vdupq_n_u8(10);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vsubq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(p + i)), zero);
+        uint8x16_t bad = vcgeq_u8(v, ten);
+        // narrow each byte's mask to a nibble so the 16 lanes fit in 64 bits
+        uint64_t m = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(bad), 4)), 0);
+        if (m) return i + size_t(__builtin_ctzll(m) >> 2);
+    }
+    return i + first_non_digit_scalar(p + i, n - i);
+}
+
+#endif
+
+using ScanFn = size_t (*)(const char*, size_t);
+
+static ScanFn pick_first_non_digit() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return first_non_digit_avx2;
+    if (__builtin_cpu_supports("sse4.2")) return first_non_digit_sse42;
+    return first_non_digit_scalar;
+#elif defined(__ARM_NEON)
+    return first_non_digit_neon;
+#else
+    return first_non_digit_scalar;
+#endif
+}
+
+// Picked on first use rather than at static initialization, so a client
+// that parses from its own static initializers never finds it unset.
+static size_t first_non_digit(const char* p, size_t n) {
+    static const ScanFn scan = pick_first_non_digit();
+    return scan(p, n);
+}
+
+/* -------------------- Run statistics -------------------- */
+
+static std::mutex stats_mutex;
+static Stats stats_total;  // blocks of threads that have exited
+
+struct ThreadStats : Stats {
+    ~ThreadStats() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats_total.merge(*this);
+    }
+};
+
+Stats& stats_local() {
+    static thread_local ThreadStats s;
+    return s;
+}
+
+Stats stats_snapshot() {
+    Stats t;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        t = stats_total;
+    }
+    t.merge(stats_local());
+    return t;
+}
+
+// The core's own counters exist only in a -DCALC_STATS build of it
+#ifdef CALC_STATS
+#define STAT_ADD(field, n) (stats_local().field += (n))
+
+static inline unsigned log2_bucket(size_t n) {
+    unsigned b = 0;
+    while (n >>= 1) ++b;
+    return std::min(b, 31u);
+}
+#else
+#define STAT_ADD(field, n) ((void)0)
+#endif
+
+/* -------------------- Validation -------------------- */
+
+// Validate x and report where its '.' is (npos for a pure integer).
+static inline ParseError scan_literal(std::string_view x, size_t& dot) {
+    dot = std::string_view::npos;
+    if (x.empty()) return ParseError::Empty;
+
+    size_t i = 0;
+    if (x[i] == '+' || x[i] == '-') {
+        ++i;
+        if (i == x.size()) return ParseError::SignOnly; // only sign is invalid
+    }
+
+    // read integer digits; must start with a digit
+    size_t j = i + first_non_digit(x.data() + i, x.size() - i);
+    if (j == i) return ParseError::NoIntDigits;
+
+    if (j == x.size()) {
+        // pure integer
+        return ParseError::None;
+    }
+
+    // if next char is '.', there must be at least one digit after it
+    if (x[j] == '.') {
+        size_t k = j + 1 + first_non_digit(x.data() + j + 1, x.size() - j - 1);
+        if (k == j + 1) return ParseError::NoFracDigits;
+        // nothing else allowed after fractional digits
+        if (k != x.size()) return ParseError::BadChar;
+        dot = j;
+        return ParseError::None;
+    }
+
+    // anything else after integer digits is invalid
+    return ParseError::BadChar;
+}
+
+ParseError scan_double_literal(std::string_view x, size_t& dot) {
+    ParseError err = scan_literal(x, dot);
+    STAT_ADD(tokens, 1);
+    STAT_ADD(rejected[size_t(err)], err != ParseError::None);
+    STAT_ADD(lengthLog2[log2_bucket(x.size())], err == ParseError::None);
+    return err;
+}
+
+bool is_valid_double_literal(std::string_view x) {
+    size_t dot;
+    return scan_double_literal(x, dot) == ParseError::None;
+}
+
+const char* parse_error_text(ParseError e) {
+    switch (e) {
+    case ParseError::None: break;
+    case ParseError::Empty: return "empty";
+    case ParseError::SignOnly: return "a sign without digits";
+    case ParseError::NoIntDigits: return "no integer digits";
+    case ParseError::NoFracDigits: return "no digits after the '.'";
+    case ParseError::BadChar: return "unexpected character";
+    }
+    return "";
+}
+
+/* -------------------- BigDecimal (limb-based) -------------------- */
+
+// Value of n (<= 9) ASCII digits.
+static inline uint32_t parse_chunk(const char* p, size_t n) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < n; ++i) v = v * 10 + uint32_t(p[i] - '0');
+    return v;
+}
+
+static inline uint32_t pow10_u32(size_t n) {
+    uint32_t p = 1;
+    while (n--) p *= 10;
+    return p;
+}
+
+// Drop zero limbs above the fraction (integer leading zeros)
+static inline void trim_high_limbs(BigDecimal& x) {
+    while (x.limbs.size() > x.frac && x.limbs.back() == 0) x.limbs.pop_back();
+}
+
+// Drop zero limbs at the bottom of the fraction (fractional trailing zeros)
+static inline void trim_low_limbs(BigDecimal& x) {
+    size_t i = 0;
+    while (i < x.frac && x.limbs[i] == 0) ++i;
+    if (i > 0) {
+        x.limbs.erase(x.limbs.begin(), x.limbs.begin() + i);
+        x.frac -= i;
+    }
+}
+
+void LimbVector::grow(size_t n, size_t keep) {
+    size_t cap = std::max(n, 2 * cap_);
+    auto* p = static_cast<uint32_t*>(resource()->allocate(cap * sizeof(uint32_t), alignof(uint32_t)));
+    STAT_ADD(limbSpills, 1);
+    std::copy(data_, data_ + keep, p);
+    if (onHeap()) resource()->deallocate(base_, cap_ * sizeof(uint32_t), alignof(uint32_t));
+    base_ = data_ = p;
+    cap_ = cap;
+}
+
+static inline void normalize(BigDecimal& x) {
+    trim_high_limbs(x);
+    trim_low_limbs(x);
+    if (x.isZero()) x.sign = +1;
+}
+
+/* -------------------- BigDecimalView (zero-copy) -------------------- */
+
+BigDecimalView make_view(std::string_view x, size_t dot) {
+    BigDecimalView v;
+    size_t i = 0;
+
+    if (x[i] == '+') { v.sign = +1; ++i; }
+    else if (x[i] == '-') { v.sign = -1; ++i; }
+
+    // split on dot if present
+    size_t intEnd = (dot == std::string_view::npos) ? x.size() : dot;
+    size_t fracBeg = (dot == std::string_view::npos) ? x.size() : dot + 1;
+    size_t fracEnd = x.size();
+
+    // normalize: skip integer leading zeros and fractional trailing zeros
+    while (i < intEnd && x[i] == '0') ++i;
+    while (fracEnd > fracBeg && x[fracEnd - 1] == '0') --fracEnd;
+
+    v.intPart = x.substr(i, intEnd - i);
+    v.fracPart = x.substr(fracBeg, fracEnd - fracBeg);
+    if (v.isZero()) v.sign = +1;
+    v.contiguous = !v.intPart.empty() && (v.sign > 0 || x[i - 1] == '-');
+    return v;
+}
+
+BigDecimalView make_view(std::string_view x) {
+    return make_view(x, x.find('.'));
+}
+
+int cmp_abs(BigDecimalView a, BigDecimalView b) {
+    if (a.intPart.size() != b.intPart.size())
+        return (a.intPart.size() < b.intPart.size()) ? -1 : +1;
+
+    int c = a.intPart.compare(b.intPart);
+    if (c != 0) return (c < 0) ? -1 : +1;
+
+    // fractions have no trailing zeros, so the longer one wins a tied prefix
+    size_t n = std::min(a.fracPart.size(), b.fracPart.size());
+    c = a.fracPart.substr(0, n).compare(b.fracPart.substr(0, n));
+    if (c != 0) return (c < 0) ? -1 : +1;
+    if (a.fracPart.size() != b.fracPart.size())
+        return (a.fracPart.size() < b.fracPart.size()) ? -1 : +1;
+    return 0;
+}
+
+void assign(BigDecimal& r, BigDecimalView v) {
+    r.sign = v.sign;
+    r.frac = (v.fracPart.size() + LIMB_DIGITS - 1) / LIMB_DIGITS;
+    r.limbs.resize(r.frac + (v.intPart.size() + LIMB_DIGITS - 1) / LIMB_DIGITS);
+
+    // fraction limbs, most significant (next to the dot) first
+    for (size_t j = 0; j < r.frac; ++j) {
+        size_t p = j * LIMB_DIGITS;
+        size_t n = std::min(LIMB_DIGITS, v.fracPart.size() - p);
+        r.limbs[r.frac - 1 - j] = parse_chunk(&v.fracPart[p], n) * pow10_u32(LIMB_DIGITS - n);
+    }
+    // integer limbs, least significant (next to the dot) first
+    size_t intEnd = v.intPart.size();
+    for (size_t k = r.frac; k < r.limbs.size(); ++k) {
+        size_t n = std::min(LIMB_DIGITS, intEnd);
+        intEnd -= n;
+        r.limbs[k] = parse_chunk(&v.intPart[intEnd], n);
+    }
+}
+
+BigDecimal parse_normalize(std::string_view x, size_t dot) {
+    BigDecimal r;
+    assign(r, make_view(x, dot));
+    return r;
+}
+
+BigDecimal parse_normalize(std::string_view x) {
+    return parse_normalize(x, x.find('.'));
+}
+
+// Up to n (<= 9) leading ASCII digits of p: their value into v, their count returned.
+static inline size_t take_chunk(const char* p, size_t n, uint32_t& v) {
+    size_t i = 0;
+    v = 0;
+    for (; i < n; ++i) {
+        uint32_t d = uint32_t(p[i] - '0');
+        if (d > 9) break;
+        v = v * 10 + d;
+    }
+    return i;
+}
+
+// Chunks of up to 9 digits from p[i], each scaled to a full limb as if it
+// were a fraction (digits next to the left edge), until a non-digit or the
+// end. Returns the digit count of the last chunk (LIMB_DIGITS if none was short).
+static inline size_t take_limbs(const char* p, size_t n, size_t& i, LimbVector& limbs) {
+    size_t last = LIMB_DIGITS;
+    while (i < n) {
+        uint32_t v;
+        size_t k = take_chunk(p + i, std::min(LIMB_DIGITS, n - i), v);
+        if (k == 0) break;
+        limbs.push_back(v * pow10_u32(LIMB_DIGITS - k));
+        i += k;
+        last = k;
+        if (k < LIMB_DIGITS) break;
+    }
+    return last;
+}
+
+static ParseError parse_literal(std::string_view x, BigDecimal& out) {
+    const char* p = x.data();
+    size_t n = x.size(), i = 0;
+    if (n == 0) return ParseError::Empty;
+    int sign = +1;
+    if (p[0] == '+' || p[0] == '-') {
+        sign = p[0] == '-' ? -1 : +1;
+        if (++i == n) return ParseError::SignOnly;
+    }
+
+    // integer digits after the leading zeros, most significant chunk first
+    size_t start = i;
+    while (i < n && p[i] == '0') ++i;
+    out.limbs.clear();
+    size_t last = take_limbs(p, n, i, out.limbs);
+    if (i == start) return ParseError::NoIntDigits;
+    size_t intLimbs = out.limbs.size();
+
+    // fraction digits, already aligned on the dot
+    if (i < n) {
+        if (p[i] != '.') return ParseError::BadChar;
+        size_t f = ++i;
+        take_limbs(p, n, i, out.limbs);
+        if (i == f) return ParseError::NoFracDigits;
+        if (i != n) return ParseError::BadChar;
+    }
+
+    // the integer chunks were cut from the left: shift them right so the
+    // short one is on top and the others end at the dot
+    if (last != LIMB_DIGITS) {
+        uint32_t lo = pow10_u32(LIMB_DIGITS - last), hi = pow10_u32(last);
+        for (size_t j = intLimbs; j-- > 1;)
+            out.limbs[j] = out.limbs[j - 1] % lo * hi + out.limbs[j] / lo;
+        out.limbs[0] /= lo;
+    }
+    while (out.limbs.size() > intLimbs && out.limbs.back() == 0) out.limbs.pop_back();
+    out.frac = out.limbs.size() - intLimbs;
+    std::reverse(out.limbs.begin(), out.limbs.end());  // least significant first
+    out.sign = out.limbs.empty() ? +1 : sign;
+    return ParseError::None;
+}
+
+ParseError try_parse(std::string_view x, BigDecimal& out) {
+    ParseError err = parse_literal(x, out);
+    STAT_ADD(tokens, 1);
+    STAT_ADD(rejected[size_t(err)], err != ParseError::None);
+    STAT_ADD(lengthLog2[log2_bucket(x.size())], err == ParseError::None);
+    return err;
+}
+
+/* -------------------- Limb arithmetic (in place) -------------------- */
+
+// Give x at least F fractional limbs by shifting in zero limbs at the bottom;
+// room left in front by an earlier trim is reused, so only the new limbs are written
+static inline void widen_frac(BigDecimal& x, size_t F) {
+    if (F <= x.frac) return;
+    x.limbs.insert(x.limbs.begin(), F - x.frac, 0);
+    x.frac = F;
+}
+
+// Limb k of x on a grid with F >= x.frac fractional limbs (zero outside x)
+static inline uint32_t limb_at(const BigDecimal& x, size_t k, size_t F) {
+    size_t shift = F - x.frac;
+    return (k >= shift && k - shift < x.limbs.size()) ? x.limbs[k - shift] : 0;
+}
+
+int cmp_abs(const BigDecimal& a, const BigDecimal& b) {
+    // compare integer length (both are trimmed at the top)
+    size_t ia = a.limbs.size() - a.frac, ib = b.limbs.size() - b.frac;
+    if (ia != ib) return (ia < ib) ? -1 : +1;
+
+    // compare limbs from the most significant end, fractions aligned implicitly
+    size_t F = std::max(a.frac, b.frac);
+    for (size_t k = ia + F; k-- > 0;) {
+        uint32_t la = limb_at(a, k, F), lb = limb_at(b, k, F);
+        if (la != lb) return (la < lb) ? -1 : +1;
+    }
+    return 0;
+}
+
+// |acc| += |b|
+static void add_abs_into(BigDecimal& acc, const BigDecimal& b) {
+    widen_frac(acc, b.frac);
+    size_t d = acc.frac - b.frac;
+    if (acc.limbs.size() < b.limbs.size() + d) acc.limbs.resize(b.limbs.size() + d, 0);
+
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < b.limbs.size(); ++i) {
+        uint32_t s = acc.limbs[i + d] + b.limbs[i] + carry;
+        carry = s >= LIMB_BASE;
+        acc.limbs[i + d] = carry ? s - LIMB_BASE : s;
+    }
+    for (i += d; carry && i < acc.limbs.size(); ++i) {
+        carry = ++acc.limbs[i] == LIMB_BASE;
+        if (carry) acc.limbs[i] = 0;
+    }
+    if (carry) acc.limbs.push_back(1);
+}
+
+// Sign of |acc| - |b| with b's limb i at acc index i + d (acc already on
+// the common fraction grid), found top-down in one pass. n is set to the
+// length below the top limbs the two share; those cancel in a subtraction.
+static int cmp_aligned(const BigDecimal& acc, const BigDecimal& b, size_t d, size_t& n) {
+    size_t na = acc.limbs.size(), nb = b.limbs.size() + d;
+    n = std::max(na, nb);
+    if (na != nb) return (na < nb) ? -1 : +1;  // both trimmed at the top
+    for (size_t k = na; k-- > 0;) {
+        uint32_t la = acc.limbs[k], lb = k >= d ? b.limbs[k - d] : 0;
+        if (la != lb) {
+            n = k + 1;
+            return (la < lb) ? -1 : +1;
+        }
+    }
+    n = 0;
+    return 0;
+}
+
+// Keep acc's low n limbs, the cancelled ones up to the fraction zeroed
+static inline void cut_cancelled(BigDecimal& acc, size_t n) {
+    acc.limbs.resize(std::max(n, acc.frac), 0);
+    std::fill(acc.limbs.begin() + n, acc.limbs.end(), 0u);
+}
+
+// |acc| = ||acc| - |b||, returning the sign of |acc| - |b|. The compare that
+// picks the direction also bounds the subtraction to the limbs below the
+// common top, so no separate cmp_abs pass is needed.
+static int sub_abs_into(BigDecimal& acc, const BigDecimal& b) {
+    widen_frac(acc, b.frac);
+    size_t d = acc.frac - b.frac, n;
+    int cmp = cmp_aligned(acc, b, d, n);
+    if (cmp == 0) {
+        acc.limbs.clear();
+        acc.frac = 0;
+        return 0;
+    }
+    cut_cancelled(acc, n);
+    size_t ny = n > d ? std::min(b.limbs.size(), n - d) : 0;  // b's limbs below the top
+
+    uint32_t borrow = 0;
+    if (cmp > 0) {
+        size_t i = 0;
+        for (; i < ny; ++i) {
+            uint32_t db = b.limbs[i] + borrow;
+            uint32_t& da = acc.limbs[i + d];
+            borrow = da < db;
+            da = borrow ? da + LIMB_BASE - db : da - db;
+        }
+        for (i += d; borrow; ++i) {
+            borrow = acc.limbs[i] == 0;
+            acc.limbs[i] = borrow ? LIMB_BASE - 1 : acc.limbs[i] - 1;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t da = (i >= d && i - d < ny) ? b.limbs[i - d] : 0;
+            uint32_t db = acc.limbs[i] + borrow;
+            borrow = da < db;
+            acc.limbs[i] = borrow ? da + LIMB_BASE - db : da - db;
+        }
+    }
+    return cmp;
+}
+
+void add_into(BigDecimal& acc, const BigDecimal& rhs) {
+    if (rhs.isZero()) return;
+    if (&acc == &rhs) {
+        BigDecimal copy = rhs;
+        add_into(acc, copy);
+        return;
+    }
+    if (acc.isZero()) {
+        acc.sign = rhs.sign;
+        acc.limbs.assign(rhs.limbs.begin(), rhs.limbs.end());
+        acc.frac = rhs.frac;
+        return;
+    }
+
+    if (acc.sign == rhs.sign) {
+        add_abs_into(acc, rhs);
+    } else if (sub_abs_into(acc, rhs) < 0) {
+        acc.sign = rhs.sign;  // opposite signs: the larger magnitude wins
+    }
+    normalize(acc);
+}
+
+/*
+   Parallel carry chains for single huge operands. The aligned limbs are cut
+   into one range per thread and every range is evaluated as if no carry (or
+   borrow) came in, recording two flags: generate, it carries out on its own,
+   and propagate, every limb came out 999999999 (adding) or 0 (subtracting),
+   so an incoming carry would ripple straight through. A scan over the flag
+   pairs gives each range its real carry in, c[p+1] = g[p] | (p[p] & c[p]),
+   and a final parallel pass applies it, stopping at the range's first limb
+   that absorbs it. Generate and propagate never both hold, so each range
+   gets at most one carry in.
+*/
+
+// Unmeasured on a multi-core box: where this was set (one core) every split
+// loses. A serial add runs about 4G digits/s there, so 2^17 limbs is ~0.3 ms
+// of work against tens of microseconds per thread started, comfortably on
+// the paying side; BM_add_parallel's rows from 2^15 digits up place the
+// real crossover.
+size_t par_add_threshold = size_t(1) << 17;
+
+enum class ChainOp { Add, Sub, RSub };  // x + y, x - y (x >= y), y - x (y >= x)
+
+// x[0, n) = x op y, y being y[i - d] at index i within [d, d + ny) and zero
+// elsewhere. Returns the carry out of the top limb (never set for Sub/RSub).
+static bool carry_chain_parallel(uint32_t* x, size_t n, const uint32_t* y, size_t d, size_t ny,
+                                 ChainOp op, unsigned threads) {
+    size_t parts = threads;
+    std::vector<uint8_t> carry(parts + 1, 0), prop(parts, 0);  // carry[p]: into range p
+    auto lo = [&](size_t p) { return n * p / parts; };
+    const uint32_t absorbed = op == ChainOp::Add ? LIMB_BASE - 1 : 0;  // limb a carry passes through
+
+    parallel_for(parts, threads, [&](size_t p) {
+        uint32_t c = 0;
+        bool all = true;
+        for (size_t i = lo(p); i < lo(p + 1); ++i) {
+            uint32_t yi = i >= d && i - d < ny ? y[i - d] : 0;
+            switch (op) {
+            case ChainOp::Add: {
+                uint32_t t = x[i] + yi + c;
+                c = t >= LIMB_BASE;
+                x[i] = c ? t - LIMB_BASE : t;
+                break;
+            }
+            case ChainOp::Sub: {
+                uint32_t t = yi + c;
+                c = x[i] < t;
+                x[i] = c ? x[i] + LIMB_BASE - t : x[i] - t;
+                break;
+            }
+            case ChainOp::RSub: {
+                uint32_t t = x[i] + c;
+                c = yi < t;
+                x[i] = c ? yi + LIMB_BASE - t : yi - t;
+                break;
+            }
+            }
+            all = all && x[i] == absorbed;
+        }
+        carry[p + 1] = uint8_t(c);
+        prop[p] = all;
+    });
+    for (size_t p = 0; p < parts; ++p) carry[p + 1] |= prop[p] & carry[p];
+    parallel_for(parts, threads, [&](size_t p) {
+        if (!carry[p]) return;
+        for (size_t i = lo(p); i < lo(p + 1); ++i) {
+            if (x[i] != absorbed) {
+                op == ChainOp::Add ? ++x[i] : --x[i];
+                return;
+            }
+            x[i] = op == ChainOp::Add ? 0 : LIMB_BASE - 1;
+        }
+    });
+    return carry[parts] != 0;
+}
+
+// |acc| += |b| on the fraction grid of both, split over `threads`
+static void chain_add_abs_into(BigDecimal& acc, const BigDecimal& b, unsigned threads) {
+    widen_frac(acc, b.frac);
+    size_t d = acc.frac - b.frac;
+    if (acc.limbs.size() < b.limbs.size() + d) acc.limbs.resize(b.limbs.size() + d, 0);
+    if (carry_chain_parallel(acc.limbs.data(), acc.limbs.size(), b.limbs.data(), d, b.limbs.size(),
+                             ChainOp::Add, threads))
+        acc.limbs.push_back(1);
+}
+
+// sub_abs_into split over `threads`: the same bounded compare-and-subtract
+static int chain_sub_abs_into(BigDecimal& acc, const BigDecimal& b, unsigned threads) {
+    widen_frac(acc, b.frac);
+    size_t d = acc.frac - b.frac, n;
+    int cmp = cmp_aligned(acc, b, d, n);
+    if (cmp == 0) {
+        acc.limbs.clear();
+        acc.frac = 0;
+        return 0;
+    }
+    cut_cancelled(acc, n);
+    size_t ny = n > d ? std::min(b.limbs.size(), n - d) : 0;
+    carry_chain_parallel(acc.limbs.data(), n, b.limbs.data(), d, ny, cmp > 0 ? ChainOp::Sub : ChainOp::RSub,
+                         threads);
+    return cmp;
+}
+
+void add_into(BigDecimal& acc, const BigDecimal& rhs, unsigned threads) {
+    if (threads <= 1 || &acc == &rhs || acc.isZero() || rhs.isZero() ||
+        std::max(acc.limbs.size(), rhs.limbs.size()) < par_add_threshold) {
+        add_into(acc, rhs);
+        return;
+    }
+    if (acc.sign == rhs.sign) {
+        chain_add_abs_into(acc, rhs, threads);
+    } else if (chain_sub_abs_into(acc, rhs, threads) < 0) {
+        acc.sign = rhs.sign;
+    }
+    normalize(acc);
+}
+
+void add_into(BigDecimal& acc, BigDecimalView rhs) {
+    static thread_local BigDecimal scratch;
+    assign(scratch, rhs);
+    add_into(acc, scratch);
+}
+
+BigDecimal add_abs(const BigDecimal& a, const BigDecimal& b) {
+    BigDecimal r;
+    copy_widened(r, a, b.frac);
+    add_abs_into(r, b);
+    r.sign = +1;
+    normalize(r);
+    return r;
+}
+
+BigDecimal sub_abs(const BigDecimal& a, const BigDecimal& b) {
+    BigDecimal r;
+    copy_widened(r, a, b.frac);
+    r.sign = sub_abs_into(r, b) < 0 ? -1 : +1;
+    normalize(r);
+    return r;
+}
+
+BigDecimal add_signed(const BigDecimal& a, const BigDecimal& b) {
+    BigDecimal r;
+    copy_widened(r, a, b.frac);
+    add_into(r, b);
+    return r;
+}
+
+/* -------------------- Multiplication -------------------- */
+/*
+   Magnitudes multiply as plain base-10^9 integers and the fractional limb
+   counts add. mul_nat picks the algorithm from the shorter operand's size
+   in limbs: schoolbook, then Karatsuba, Toom-3 and finally a three-prime
+   NTT. The crossovers live in mul_thresholds so bench.cpp can tune them.
+*/
+
+MulThresholds mul_thresholds;
+
+using Limbs = std::vector<uint32_t>;
+
+static inline void trim_nat(Limbs& x) {
+    while (!x.empty() && x.back() == 0) x.pop_back();
+}
+
+static Limbs nat_slice(const uint32_t* p, size_t n, size_t lo, size_t hi) {
+    hi = std::min(hi, n);
+    if (lo >= hi) return {};
+    Limbs r(p + lo, p + hi);
+    trim_nat(r);
+    return r;
+}
+
+static int nat_cmp(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : +1;
+    for (size_t i = a.size(); i-- > 0;)
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : +1;
+    return 0;
+}
+
+// r += x * BASE^shift
+static void nat_add_into(Limbs& r, const Limbs& x, size_t shift = 0) {
+    if (x.empty()) return;
+    if (r.size() < x.size() + shift) r.resize(x.size() + shift, 0);
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < x.size(); ++i) {
+        uint32_t s = r[i + shift] + x[i] + carry;
+        carry = s >= LIMB_BASE;
+        r[i + shift] = carry ? s - LIMB_BASE : s;
+    }
+    for (i += shift; carry; ++i) {
+        if (i == r.size()) r.push_back(0);
+        carry = ++r[i] == LIMB_BASE;
+        if (carry) r[i] = 0;
+    }
+}
+
+// r -= x, assumes r >= x
+static void nat_sub_into(Limbs& r, const Limbs& x) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < x.size(); ++i) {
+        uint32_t d = x[i] + borrow;
+        borrow = r[i] < d;
+        r[i] = borrow ? r[i] + LIMB_BASE - d : r[i] - d;
+    }
+    for (; borrow; ++i) {
+        borrow = r[i] == 0;
+        r[i] = borrow ? LIMB_BASE - 1 : r[i] - 1;
+    }
+    trim_nat(r);
+}
+
+static Limbs nat_add(const Limbs& a, const Limbs& b) {
+    Limbs r = a;
+    nat_add_into(r, b);
+    return r;
+}
+
+static Limbs mul_nat(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+static Limbs mul_nat(const Limbs& a, const Limbs& b) {
+    return mul_nat(a.data(), a.size(), b.data(), b.size());
+}
+
+static Limbs mul_basecase(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    Limbs r(na + nb, 0);
+    for (size_t i = 0; i < na; ++i) {
+        uint64_t ai = a[i], carry = 0;
+        if (ai == 0) continue;
+        for (size_t j = 0; j < nb; ++j) {
+            uint64_t t = r[i + j] + ai * b[j] + carry;
+            r[i + j] = uint32_t(t % LIMB_BASE);
+            carry = t / LIMB_BASE;
+        }
+        r[i + nb] = uint32_t(carry);
+    }
+    trim_nat(r);
+    return r;
+}
+
+// na >= nb > na / 2
+static Limbs mul_karatsuba(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t m = (na + 1) / 2;
+    Limbs a0 = nat_slice(a, na, 0, m), a1 = nat_slice(a, na, m, na);
+    Limbs b0 = nat_slice(b, nb, 0, m), b1 = nat_slice(b, nb, m, nb);
+
+    Limbs z0 = mul_nat(a0, b0);
+    Limbs z2 = mul_nat(a1, b1);
+    Limbs z1 = mul_nat(nat_add(a0, a1), nat_add(b0, b1));
+    nat_sub_into(z1, z0);
+    nat_sub_into(z1, z2);
+
+    Limbs r = std::move(z0);
+    nat_add_into(r, z1, m);
+    nat_add_into(r, z2, 2 * m);
+    return r;
+}
+
+// Signed magnitude for Toom-3's evaluation points
+struct SignedNat {
+    bool neg = false;
+    Limbs mag;
+};
+
+static SignedNat s_add(const SignedNat& x, const SignedNat& y) {
+    if (x.neg == y.neg) return {x.neg, nat_add(x.mag, y.mag)};
+    int c = nat_cmp(x.mag, y.mag);
+    if (c == 0) return {};
+    const SignedNat& big = c > 0 ? x : y;
+    const SignedNat& small = c > 0 ? y : x;
+    SignedNat r = big;
+    nat_sub_into(r.mag, small.mag);
+    return r;
+}
+
+static SignedNat s_sub(const SignedNat& x, SignedNat y) {
+    if (!y.mag.empty()) y.neg = !y.neg;
+    return s_add(x, y);
+}
+
+static SignedNat s_mul(const SignedNat& x, const SignedNat& y) {
+    SignedNat r{false, mul_nat(x.mag, y.mag)};
+    r.neg = !r.mag.empty() && x.neg != y.neg;
+    return r;
+}
+
+static SignedNat s_mul_small(SignedNat x, uint32_t m) {
+    uint64_t carry = 0;
+    for (uint32_t& l : x.mag) {
+        uint64_t t = uint64_t(l) * m + carry;
+        l = uint32_t(t % LIMB_BASE);
+        carry = t / LIMB_BASE;
+    }
+    if (carry) x.mag.push_back(uint32_t(carry));
+    return x;
+}
+
+// x / d for a d that divides x exactly
+static SignedNat s_div_exact(SignedNat x, uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = x.mag.size(); i-- > 0;) {
+        uint64_t cur = rem * LIMB_BASE + x.mag[i];
+        x.mag[i] = uint32_t(cur / d);
+        rem = cur % d;
+    }
+    trim_nat(x.mag);
+    if (x.mag.empty()) x.neg = false;
+    return x;
+}
+
+// Toom-3 with evaluation points 0, 1, -1, -2, inf and Bodrato's
+// interpolation sequence; na >= nb > na / 2.
+static Limbs mul_toom3(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t k = (na + 2) / 3;
+    SignedNat a0{false, nat_slice(a, na, 0, k)}, a1{false, nat_slice(a, na, k, 2 * k)},
+              a2{false, nat_slice(a, na, 2 * k, na)};
+    SignedNat b0{false, nat_slice(b, nb, 0, k)}, b1{false, nat_slice(b, nb, k, 2 * k)},
+              b2{false, nat_slice(b, nb, 2 * k, nb)};
+
+    // p(1), p(-1), p(-2) for p = x0 + x1 t + x2 t^2
+    auto eval = [](const SignedNat& x0, const SignedNat& x1, const SignedNat& x2,
+                   SignedNat& p1, SignedNat& pm1, SignedNat& pm2) {
+        SignedNat t = s_add(x0, x2);
+        p1 = s_add(t, x1);
+        pm1 = s_sub(t, x1);
+        pm2 = s_sub(s_mul_small(s_add(pm1, x2), 2), x0);
+    };
+    SignedNat pa1, pam1, pam2, pb1, pbm1, pbm2;
+    eval(a0, a1, a2, pa1, pam1, pam2);
+    eval(b0, b1, b2, pb1, pbm1, pbm2);
+
+    SignedNat r0 = s_mul(a0, b0);
+    SignedNat r1 = s_mul(pa1, pb1);
+    SignedNat rm1 = s_mul(pam1, pbm1);
+    SignedNat rm2 = s_mul(pam2, pbm2);
+    SignedNat rinf = s_mul(a2, b2);
+
+    SignedNat r3 = s_div_exact(s_sub(rm2, r1), 3);
+    r1 = s_div_exact(s_sub(r1, rm1), 2);
+    SignedNat r2 = s_sub(rm1, r0);
+    r3 = s_add(s_div_exact(s_sub(r2, r3), 2), s_mul_small(rinf, 2));
+    r2 = s_sub(s_add(r2, r1), rinf);
+    r1 = s_sub(r1, r3);
+
+    // every coefficient of the product polynomial is non-negative
+    Limbs r = std::move(r0.mag);
+    nat_add_into(r, r1.mag, k);
+    nat_add_into(r, r2.mag, 2 * k);
+    nat_add_into(r, r3.mag, 3 * k);
+    nat_add_into(r, rinf.mag, 4 * k);
+    trim_nat(r);
+    return r;
+}
+
+/*
+   NTT over three ~30-bit primes (root 3 for each). Every convolution term is
+   below min(na, nb) * 10^18, which fits under their product (~7.8e25) for
+   any length the transforms support, so CRT recovers it exactly.
+*/
+static constexpr uint32_t NTT_PRIMES[3] = {998244353u, 167772161u, 469762049u};
+static constexpr size_t NTT_MAX_LEN = size_t(1) << 23;  // 2-adic limit of the first prime
+
+static uint32_t pow_mod(uint64_t b, uint64_t e, uint32_t m) {
+    uint64_t r = 1;
+    b %= m;
+    for (; e; e >>= 1, b = b * b % m)
+        if (e & 1) r = r * b % m;
+    return uint32_t(r);
+}
+
+static void ntt(std::vector<uint32_t>& a, bool invert, uint32_t mod) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        uint64_t w = pow_mod(3, (mod - 1) / len, mod);
+        if (invert) w = pow_mod(w, mod - 2, mod);
+        std::vector<uint32_t> ws(len / 2);
+        ws[0] = 1;
+        for (size_t k = 1; k < len / 2; ++k) ws[k] = uint32_t(ws[k - 1] * w % mod);
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < len / 2; ++k) {
+                uint32_t u = a[i + k];
+                uint32_t v = uint32_t(uint64_t(a[i + k + len / 2]) * ws[k] % mod);
+                a[i + k] = u + v >= mod ? u + v - mod : u + v;
+                a[i + k + len / 2] = u >= v ? u - v : u + mod - v;
+            }
+        }
+    }
+    if (invert) {
+        uint64_t inv = pow_mod(n, mod - 2, mod);
+        for (uint32_t& x : a) x = uint32_t(x * inv % mod);
+    }
+}
+
+static Limbs mul_ntt(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t n = 1;
+    while (n < na + nb - 1) n <<= 1;
+
+    std::vector<uint32_t> res[3];
+    for (int p = 0; p < 3; ++p) {
+        uint32_t mod = NTT_PRIMES[p];
+        std::vector<uint32_t> fa(n, 0), fb(n, 0);
+        for (size_t i = 0; i < na; ++i) fa[i] = a[i] % mod;
+        for (size_t i = 0; i < nb; ++i) fb[i] = b[i] % mod;
+        ntt(fa, false, mod);
+        ntt(fb, false, mod);
+        for (size_t i = 0; i < n; ++i) fa[i] = uint32_t(uint64_t(fa[i]) * fb[i] % mod);
+        ntt(fa, true, mod);
+        res[p] = std::move(fa);
+    }
+
+    // Garner's CRT, then carries in base 10^9
+    const uint64_t p0 = NTT_PRIMES[0], p1 = NTT_PRIMES[1], p2 = NTT_PRIMES[2];
+    const uint64_t inv_p0_mod_p1 = pow_mod(p0, p1 - 2, uint32_t(p1));
+    const uint64_t p01_mod_p2 = p0 * p1 % p2;
+    const uint64_t inv_p01_mod_p2 = pow_mod(p01_mod_p2, p2 - 2, uint32_t(p2));
+
+    Limbs r(na + nb, 0);
+    u128 carry = 0;
+    for (size_t i = 0; i < na + nb; ++i) {
+        u128 v = carry;
+        if (i < na + nb - 1) {
+            uint64_t x0 = res[0][i];
+            uint64_t t1 = (res[1][i] + p1 - x0 % p1) % p1 * inv_p0_mod_p1 % p1;
+            uint64_t x01 = x0 + p0 * t1;  // < p0 * p1
+            uint64_t t2 = (res[2][i] + p2 - x01 % p2) % p2 * inv_p01_mod_p2 % p2;
+            v += x01 + u128(p0 * p1) * t2;
+        }
+        r[i] = uint32_t(v % LIMB_BASE);
+        carry = v / LIMB_BASE;
+    }
+    trim_nat(r);
+    return r;
+}
+
+static Limbs mul_nat(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    while (na > 0 && a[na - 1] == 0) --na;
+    while (nb > 0 && b[nb - 1] == 0) --nb;
+    if (na == 0 || nb == 0) return {};
+    if (na < nb) { std::swap(a, b); std::swap(na, nb); }
+
+    const MulThresholds& t = mul_thresholds;
+    if (nb < t.karatsuba) return mul_basecase(a, na, b, nb);
+    if (nb >= t.ntt && na + nb <= NTT_MAX_LEN) return mul_ntt(a, na, b, nb);
+
+    if (na > 2 * nb) {
+        // unbalanced: multiply nb-limb slices of a and add them up
+        Limbs r;
+        for (size_t lo = 0; lo < na; lo += nb)
+            nat_add_into(r, mul_nat(a + lo, std::min(nb, na - lo), b, nb), lo);
+        trim_nat(r);
+        return r;
+    }
+    if (nb >= t.toom3) return mul_toom3(a, na, b, nb);
+    return mul_karatsuba(a, na, b, nb);
+}
+
+BigDecimal mul(const BigDecimal& a, const BigDecimal& b) {
+    BigDecimal r;
+    if (a.isZero() || b.isZero()) return r;
+    Limbs p = mul_nat(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size());
+    r.limbs.assign(p.begin(), p.end());
+    r.frac = a.frac + b.frac;
+    if (r.limbs.size() < r.frac) r.limbs.resize(r.frac, 0);
+    r.sign = a.sign * b.sign;
+    normalize(r);
+    return r;
+}
+
+/* -------------------- Rounding context -------------------- */
+
+void round_to(BigDecimal& x, size_t digits, RoundingMode mode) {
+    if (x.frac == 0 || digits >= x.frac * LIMB_DIGITS) return;
+
+    size_t keep = (digits + LIMB_DIGITS - 1) / LIMB_DIGITS;  // fractional limbs kept
+    size_t c = x.frac - keep;                                // lowest kept limb
+    uint32_t unit = pow10_u32(keep * LIMB_DIGITS - digits);  // one unit of the last kept digit
+    if (c == x.limbs.size()) x.limbs.push_back(0);           // 0.xxx rounded to an integer
+
+    // the dropped part against half a unit: its leading digits decide,
+    // anything nonzero below them breaks a tie upwards
+    uint32_t r = x.limbs[c] % unit;  // dropped digits inside limb c
+    uint32_t lead = r, half = unit / 2;
+    size_t rest = c;                 // limbs [0, rest) are the remainder
+    if (unit == 1) {
+        lead = x.limbs[c - 1];
+        half = LIMB_BASE / 2;
+        rest = c - 1;
+    }
+    bool sticky = false;
+    for (size_t i = 0; i < rest && !sticky; ++i) sticky = x.limbs[i] != 0;
+    int vsHalf = lead < half ? -1 : lead > half ? +1 : sticky ? +1 : 0;
+    bool dropped = lead != 0 || sticky;
+
+    bool up = false;
+    switch (mode) {
+    case RoundingMode::HalfUp:   up = dropped && vsHalf >= 0; break;
+    case RoundingMode::HalfEven: up = vsHalf > 0 || (vsHalf == 0 && (x.limbs[c] / unit) % 2 == 1); break;
+    case RoundingMode::Truncate: up = false; break;
+    }
+
+    x.limbs[c] -= r;
+    x.limbs.erase(x.limbs.begin(), x.limbs.begin() + c);
+    x.frac = keep;
+    if (up) {
+        uint32_t carry = unit;
+        for (size_t i = 0; carry; ++i) {
+            if (i == x.limbs.size()) x.limbs.push_back(0);
+            uint32_t s = x.limbs[i] + carry;
+            carry = s >= LIMB_BASE;
+            x.limbs[i] = carry ? s - LIMB_BASE : s;
+        }
+    }
+    normalize(x);
+}
+
+BigDecimal add_signed(const BigDecimal& a, const BigDecimal& b, const DecimalContext& ctx) {
+    BigDecimal r = add_signed(a, b);
+    round_to(r, ctx.precision, ctx.rounding);
+    return r;
+}
+
+/* -------------------- Division -------------------- */
+/*
+   Integer quotients come from Knuth's algorithm D, or, once both the
+   divisor and the quotient reach div_newton_threshold limbs, from a
+   Newton-Raphson reciprocal built on mul_nat followed by an exact fix-up.
+   The crossover sits near 12800 limbs on an AVX2 box (BM_div in bench.cpp).
+*/
+
+size_t div_newton_threshold = 12800;
+
+// x /= d for a divisor below 10^18; returns the remainder
+static uint64_t nat_div_small(Limbs& x, uint64_t d) {
+    u128 rem = 0;
+    for (size_t i = x.size(); i-- > 0;) {
+        u128 cur = rem * LIMB_BASE + x[i];
+        x[i] = uint32_t(cur / d);
+        rem = cur % d;
+    }
+    trim_nat(x);
+    return uint64_t(rem);
+}
+
+static Limbs nat_shift_up(const Limbs& x, size_t limbs) {
+    if (x.empty()) return {};
+    Limbs r(limbs, 0);
+    r.insert(r.end(), x.begin(), x.end());
+    return r;
+}
+
+static void nat_shift_down(Limbs& x, size_t limbs) {
+    x.erase(x.begin(), x.begin() + std::min(limbs, x.size()));
+}
+
+// Knuth D: q = a / b, r = a % b for b with at least two limbs
+static void divmod_knuth(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r) {
+    size_t n = b.size(), m = a.size() - n;
+    // normalize so the divisor's top limb is at least BASE / 2
+    uint32_t d = uint32_t(LIMB_BASE / (uint64_t(b.back()) + 1));
+    SignedNat u = s_mul_small({false, a}, d), v = s_mul_small({false, b}, d);
+    u.mag.resize(a.size() + 1, 0);
+    const uint64_t vt = v.mag[n - 1], vs = v.mag[n - 2];
+
+    q.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        uint64_t num = uint64_t(u.mag[j + n]) * LIMB_BASE + u.mag[j + n - 1];
+        uint64_t qhat = num / vt, rhat = num % vt;
+        while (qhat >= LIMB_BASE || qhat * vs > rhat * LIMB_BASE + u.mag[j + n - 2]) {
+            --qhat;
+            rhat += vt;
+            if (rhat >= LIMB_BASE) break;
+        }
+
+        // u[j .. j+n] -= qhat * v
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i <= n; ++i) {
+            uint64_t p = (i < n ? qhat * v.mag[i] : 0) + carry;
+            carry = p / LIMB_BASE;
+            int64_t t = int64_t(u.mag[i + j]) - int64_t(p % LIMB_BASE) - borrow;
+            borrow = t < 0;
+            u.mag[i + j] = uint32_t(t < 0 ? t + LIMB_BASE : t);
+        }
+        if (borrow) {
+            // qhat was one too large: add v back
+            --qhat;
+            uint32_t c = 0;
+            for (size_t i = 0; i <= n; ++i) {
+                uint32_t s = u.mag[i + j] + (i < n ? v.mag[i] : 0) + c;
+                c = s >= LIMB_BASE;
+                u.mag[i + j] = c ? s - LIMB_BASE : s;
+            }
+        }
+        q[j] = uint32_t(qhat);
+    }
+    trim_nat(q);
+    u.mag.resize(n);
+    trim_nat(u.mag);
+    r = s_div_exact(u, d).mag;
+}
+
+// x ~ BASE^s / b (within a few units) by Newton-Raphson: x += x (BASE^s - b x) / BASE^s
+static Limbs reciprocal(const Limbs& b, size_t s) {
+    size_t n = b.size();
+    // start from the top two limbs: about nine correct digits
+    uint64_t top = uint64_t(b[n - 1]) * LIMB_BASE + b[n - 2];
+    Limbs x(s - n + 3, 0);
+    x.back() = 1;  // BASE^(s - n + 2)
+    nat_div_small(x, top);
+
+    SignedNat one{false, Limbs(s + 1, 0)};
+    one.mag.back() = 1;  // BASE^s
+    const SignedNat bs{false, b};
+    for (size_t good = LIMB_DIGITS, iter = 0; iter < 64; good *= 2, ++iter) {
+        SignedNat e = s_sub(one, s_mul(bs, {false, x}));
+        SignedNat dx = s_mul({false, x}, e);
+        nat_shift_down(dx.mag, s);
+        if (dx.mag.empty()) break;
+        x = s_add({false, x}, dx).mag;
+        if (good > (s - n + 2) * LIMB_DIGITS * 2) break;  // converged to within a unit or two
+    }
+    return x;
+}
+
+static void divmod_newton(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r) {
+    size_t s = a.size() + 1;
+    q = mul_nat(a, reciprocal(b, s));
+    nat_shift_down(q, s);
+
+    // the estimate is off by a few units at most: step it onto floor(a / b)
+    Limbs qb = mul_nat(q, b);
+    while (nat_cmp(qb, a) > 0) {
+        nat_sub_into(q, Limbs{1});
+        nat_sub_into(qb, b);
+    }
+    r = a;
+    nat_sub_into(r, qb);
+    while (nat_cmp(r, b) >= 0) {
+        nat_add_into(q, Limbs{1});
+        nat_sub_into(r, b);
+    }
+}
+
+// q = a / b, r = a % b for trimmed a and nonzero trimmed b
+static void divmod_nat(const Limbs& a, const Limbs& b, Limbs& q, Limbs& r) {
+    if (nat_cmp(a, b) < 0) { q.clear(); r = a; return; }
+    if (b.size() == 1) {
+        q = a;
+        uint64_t rem = nat_div_small(q, b[0]);
+        r.assign(rem ? 1 : 0, uint32_t(rem));
+        return;
+    }
+    size_t qlen = a.size() - b.size() + 1;
+    if (b.size() >= div_newton_threshold && qlen >= div_newton_threshold) divmod_newton(a, b, q, r);
+    else divmod_knuth(a, b, q, r);
+}
+
+BigDecimal div(const BigDecimal& a, const BigDecimal& b, size_t precision, RoundingMode mode) {
+    BigDecimal q;
+    if (a.isZero() || b.isZero()) return q;
+    if (precision == SIZE_MAX) precision = DIV_DEFAULT_PRECISION;
+
+    // a = A / BASE^fa, b = B / BASE^fb, so the quotient with F fractional
+    // limbs is floor(A * BASE^(F + fb - fa) / B); F has a guard limb past
+    // `precision` so the rounding digit is always computed
+    size_t F = (precision + LIMB_DIGITS - 1) / LIMB_DIGITS + 1;
+    Limbs A(a.limbs.begin(), a.limbs.end()), B(b.limbs.begin(), b.limbs.end());
+    trim_nat(A);
+    trim_nat(B);
+    if (F + b.frac >= a.frac) A = nat_shift_up(A, F + b.frac - a.frac);
+    else B = nat_shift_up(B, a.frac - F - b.frac);
+
+    Limbs quot, rem;
+    divmod_nat(A, B, quot, rem);
+    q.limbs.assign(quot.begin(), quot.end());
+    q.frac = F;
+    if (!rem.empty()) {
+        // sticky limb under the guard digits: a nonzero remainder breaks ties upwards
+        q.limbs.insert(q.limbs.begin(), 1u);
+        q.frac = F + 1;
+    }
+    if (q.limbs.size() < q.frac) q.limbs.resize(q.frac, 0);
+    q.sign = a.sign * b.sign;
+    normalize(q);
+    round_to(q, precision, mode);
+    return q;
+}
+
+// Append exactly 9 digits of a limb (zero padded)
+static inline void put_limb9(string& out, uint32_t v) {
+    char buf[LIMB_DIGITS];
+    for (size_t i = LIMB_DIGITS; i-- > 0;) { buf[i] = char('0' + v % 10); v /= 10; }
+    out.append(buf, LIMB_DIGITS);
+}
+
+void to_string(const BigDecimal& x, string& out) {
+    if (x.isZero()) { out.push_back('0'); return; }
+    if (x.sign < 0) out.push_back('-');
+
+    size_t n = x.limbs.size();
+    if (n == x.frac) {
+        out.push_back('0');
+    } else {
+        char top[LIMB_DIGITS];
+        size_t len = 0;
+        for (uint32_t v = x.limbs[n - 1]; v; v /= 10) top[len++] = char('0' + v % 10);
+        while (len) out.push_back(top[--len]);  // top limb is unpadded
+        for (size_t i = n - 1; i-- > x.frac;) put_limb9(out, x.limbs[i]);
+    }
+    if (x.frac > 0) {
+        out.push_back('.');
+        for (size_t i = x.frac; i-- > 0;) put_limb9(out, x.limbs[i]);
+        // last limb was padded on the right
+        while (out.back() == '0') out.pop_back();
+    }
+}
+
+string to_string(const BigDecimal& x) {
+    string out;
+    to_string(x, out);
+    return out;
+}
+
+/* -------------------- SmallDecimal (128-bit fast path) -------------------- */
+
+// |x| * 10^k in place; false on overflow of 128 bits
+static inline bool mul_pow10(u128& x, size_t k) {
+    if (x == 0 || k == 0) return true;
+    if (k > SMALL_MAX_DIGITS) return false;
+    u128 p = k < 20 ? u128(POW10_U64[k]) : u128(POW10_U64[19]) * POW10_U64[k - 19];
+    if (x > ~u128(0) / p) return false;
+    x *= p;
+    return true;
+}
+
+static inline u128 abs_u128(i128 x) {
+    return x < 0 ? -u128(x) : u128(x);
+}
+
+static inline void normalize(SmallDecimal& x) {
+    while (x.scale > 0 && x.mant % 10 == 0) { x.mant /= 10; --x.scale; }
+    if (x.mant == 0) x.scale = 0;
+}
+
+bool assign(SmallDecimal& r, BigDecimalView v) {
+    size_t n = v.intPart.size() + v.fracPart.size();
+    if (n > SMALL_MAX_DIGITS) return false;
+
+    // 18-digit chunks in 64-bit arithmetic, one 128-bit multiply per chunk
+    u128 m = 0;
+    if (n <= 19) {
+        uint64_t c = 0;
+        for (char d : v.intPart) c = c * 10 + uint64_t(d - '0');
+        for (char d : v.fracPart) c = c * 10 + uint64_t(d - '0');
+        m = c;
+    } else for (std::string_view part : {v.intPart, v.fracPart}) {
+        for (size_t p = 0; p < part.size();) {
+            size_t len = std::min<size_t>(18, part.size() - p);
+            uint64_t c = 0;
+            for (size_t i = 0; i < len; ++i) c = c * 10 + uint64_t(part[p + i] - '0');
+            m = m * POW10_U64[len] + c;
+            p += len;
+        }
+    }
+    r.mant = v.sign < 0 ? -i128(m) : i128(m);
+    r.scale = uint32_t(v.fracPart.size());
+    return true;
+}
+
+// x * 10^k, false on overflow
+static inline bool scale_up(i128 x, size_t k, i128& out) {
+    u128 m = abs_u128(x);
+    if (!mul_pow10(m, k) || m > u128(~u128(0) >> 1)) return false;
+    out = x < 0 ? -i128(m) : i128(m);
+    return true;
+}
+
+bool add_small(const SmallDecimal& a, const SmallDecimal& b, SmallDecimal& r) {
+    uint32_t S = std::max(a.scale, b.scale);
+    i128 x, y;
+    if (!scale_up(a.mant, S - a.scale, x) || !scale_up(b.mant, S - b.scale, y)) return false;
+    if (__builtin_add_overflow(x, y, &r.mant)) return false;
+    r.scale = S;
+    normalize(r);
+    return true;
+}
+
+bool mul_small(const SmallDecimal& a, const SmallDecimal& b, SmallDecimal& r) {
+    if (__builtin_mul_overflow(a.mant, b.mant, &r.mant)) return false;
+    r.scale = a.scale + b.scale;
+    normalize(r);
+    return true;
+}
+
+int cmp_abs(const SmallDecimal& a, const SmallDecimal& b) {
+    u128 x = abs_u128(a.mant), y = abs_u128(b.mant);
+    // align to the larger scale; a magnitude that overflows doing so is the larger one
+    if (a.scale < b.scale && !mul_pow10(x, b.scale - a.scale)) return +1;
+    if (b.scale < a.scale && !mul_pow10(y, a.scale - b.scale)) return -1;
+    return x < y ? -1 : x > y ? +1 : 0;
+}
+
+void assign(BigDecimal& r, const SmallDecimal& x) {
+    u128 m = abs_u128(x.mant);
+    r.sign = x.mant < 0 ? -1 : +1;
+    r.frac = (x.scale + LIMB_DIGITS - 1) / LIMB_DIGITS;
+    r.limbs.clear();
+
+    // a partial bottom limb is padded on the right
+    size_t head = x.scale % LIMB_DIGITS;
+    if (head) {
+        uint32_t p = pow10_u32(head);
+        r.limbs.push_back(uint32_t(m % p) * pow10_u32(LIMB_DIGITS - head));
+        m /= p;
+    }
+    for (; m != 0 || r.limbs.size() < r.frac; m /= LIMB_BASE) r.limbs.push_back(uint32_t(m % LIMB_BASE));
+}
+
+void to_string(const SmallDecimal& x, string& out) {
+    if (x.mant == 0) { out.push_back('0'); return; }
+    u128 m = abs_u128(x.mant);
+    char buf[40];
+    char* end = buf + sizeof buf;
+    char* p = end;
+    // two 64-bit halves keep the digit loop out of 128-bit division
+    uint64_t lo = uint64_t(m), hi = 0;
+    if (m >= POW10_U64[19]) {
+        hi = uint64_t(m / POW10_U64[19]);
+        lo = uint64_t(m - u128(hi) * POW10_U64[19]);
+    }
+    for (int i = 0; i < 19 && (lo || hi); ++i) { *--p = char('0' + lo % 10); lo /= 10; }
+    for (; hi; hi /= 10) *--p = char('0' + hi % 10);
+
+    size_t digits = size_t(end - p);
+    if (x.mant < 0) out.push_back('-');
+    if (digits <= x.scale) {
+        out += "0.";
+        out.append(x.scale - digits, '0');
+        out.append(p, digits);
+    } else {
+        out.append(p, digits - x.scale);
+        if (x.scale) {
+            out.push_back('.');
+            out.append(end - x.scale, x.scale);
+        }
+    }
+}
+
+/* -------------------- ASCII digit path -------------------- */
+/*
+   Sums of two views worked out on the digit text itself: the operands are
+   laid out on a common dot and the result is produced as a view into a
+   scratch buffer, so a case that is echoed and printed never goes through
+   limbs at all. The kernels add/subtract n aligned ASCII digits in place
+   and return the carry/borrow out of the most significant digit.
+
+   The AVX2 kernels take 32 digits per step with no per-digit branch: lane
+   sums give generate (d > 9 resp. d < 0) and propagate (d == 9 resp.
+   d == 0) bitmasks, and one 64-bit addition, ((g | p) + g + cin) ^ p,
+   turns them into the carry into every lane at once.
+*/
+
+static bool add_digits_scalar(char* x, const char* y, size_t n, bool carry) {
+    unsigned c = carry;
+    for (size_t i = n; i-- > 0;) {
+        unsigned s = unsigned(x[i] - '0') + unsigned(y[i] - '0') + c;
+        c = s > 9;
+        x[i] = char('0' + s - 10 * c);
+    }
+    return c;
+}
+
+static bool sub_digits_scalar(char* x, const char* y, size_t n, bool borrow) {
+    int b = borrow;
+    for (size_t i = n; i-- > 0;) {
+        int d = int(x[i]) - int(y[i]) - b;
+        b = d < 0;
+        x[i] = char('0' + d + 10 * b);
+    }
+    return b;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Reverse the 32 bytes of v, so lane 0 holds the least significant digit
+// and carries run from bit i to bit i + 1 of the lane masks.
+__attribute__((target("avx2")))
+static inline __m256i reverse_bytes(__m256i v) {
+    const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    v = _mm256_shuffle_epi8(v, rev);
+    return _mm256_permute2x128_si256(v, v, 1);
+}
+
+// Spread bit i of m to byte i (0x00 / 0xff).
+__attribute__((target("avx2")))
+static inline __m256i expand_mask(uint32_t m) {
+    const __m256i pick = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                          2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bits = _mm256_set1_epi64x(int64_t(0x8040201008040201ull));
+    __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(int32_t(m)), pick);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+}
+
+// Carry into each lane from generate/propagate masks; *cin becomes the carry out.
+static inline uint32_t lane_carries(uint32_t g, uint32_t p, unsigned* cin) {
+    uint64_t s = uint64_t(g | p) + g + *cin;
+    *cin = unsigned(s >> 32);
+    return uint32_t(s) ^ p;
+}
+
+__attribute__((target("avx2")))
+static bool add_digits_avx2(char* x, const char* y, size_t n, bool carry) {
+    const __m256i zero2 = _mm256_set1_epi8(2 * '0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i zero = _mm256_set1_epi8('0');
+    unsigned c = carry;
+    size_t i = n;
+    for (; i >= 32; i -= 32) {
+        __m256i* px = reinterpret_cast<__m256i*>(x + i - 32);
+        __m256i d = _mm256_sub_epi8(_mm256_add_epi8(_mm256_loadu_si256(px),
+                                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i - 32))),
+                                    zero2);
+        d = reverse_bytes(d);  // 0..18 per lane
+        uint32_t g = uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(d, nine)));
+        uint32_t p = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, nine)));
+        d = _mm256_sub_epi8(d, expand_mask(lane_carries(g, p, &c)));  // mask lanes are -1
+        // 0..19 -> 0..9: where d < 10, d - 10 wraps above it and min keeps d
+        d = _mm256_min_epu8(d, _mm256_sub_epi8(d, ten));
+        _mm256_storeu_si256(px, _mm256_add_epi8(reverse_bytes(d), zero));
+    }
+    return add_digits_scalar(x, y, i, c);
+}
+
+__attribute__((target("avx2")))
+static bool sub_digits_avx2(char* x, const char* y, size_t n, bool borrow) {
+    const __m256i zeroes = _mm256_setzero_si256();
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i zero = _mm256_set1_epi8('0');
+    unsigned b = borrow;
+    size_t i = n;
+    for (; i >= 32; i -= 32) {
+        __m256i* px = reinterpret_cast<__m256i*>(x + i - 32);
+        __m256i d = _mm256_sub_epi8(_mm256_loadu_si256(px),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i - 32)));
+        d = reverse_bytes(d);  // -9..9 per lane
+        uint32_t g = uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(zeroes, d)));
+        uint32_t p = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, zeroes)));
+        d = _mm256_add_epi8(d, expand_mask(lane_carries(g, p, &b)));
+        // -10..9 -> 0..9: a negative d is >= 246 unsigned, so min picks d + 10
+        d = _mm256_min_epu8(d, _mm256_add_epi8(d, ten));
+        _mm256_storeu_si256(px, _mm256_add_epi8(reverse_bytes(d), zero));
+    }
+    return sub_digits_scalar(x, y, i, b);
+}
+
+#endif
+
+using DigitsFn = bool (*)(char*, const char*, size_t, bool);
+
+static DigitsFn pick_digits_kernel(bool sub) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return sub ? sub_digits_avx2 : add_digits_avx2;
+#endif
+    return sub ? sub_digits_scalar : add_digits_scalar;
+}
+
+// Picked on first use, as first_non_digit is
+static bool add_digits(char* x, const char* y, size_t n, bool carry) {
+    static const DigitsFn kernel = pick_digits_kernel(false);
+    return kernel(x, y, n, carry);
+}
+
+static bool sub_digits(char* x, const char* y, size_t n, bool borrow) {
+    static const DigitsFn kernel = pick_digits_kernel(true);
+    return kernel(x, y, n, borrow);
+}
+
+// Copy |v| into dst on an I.F digit grid, zero-filled on both sides.
+static void put_aligned(char* dst, BigDecimalView v, size_t I, size_t F) {
+    size_t lead = I - v.intPart.size();
+    std::memset(dst, '0', lead);
+    std::memcpy(dst + lead, v.intPart.data(), v.intPart.size());
+    std::memcpy(dst + I, v.fracPart.data(), v.fracPart.size());
+    std::memset(dst + I + v.fracPart.size(), '0', F - v.fracPart.size());
+}
+
+BigDecimalView add_views(BigDecimalView a, BigDecimalView b, string& buf, string& pad) {
+    int cmp = a.sign == b.sign ? 0 : cmp_abs(a, b);
+    if (a.sign != b.sign && cmp == 0) return BigDecimalView{};
+    if (cmp < 0) std::swap(a, b);  // subtract the smaller magnitude
+
+    size_t I = std::max(a.intPart.size(), b.intPart.size());
+    size_t F = std::max(a.fracPart.size(), b.fracPart.size());
+    // buf: a slot for the sign, one spare digit for the carry, then the I.F grid
+    buf.resize(2 + I + F);
+    pad.resize(I + F);
+    buf[1] = '0';
+    put_aligned(&buf[2], a, I, F);
+    put_aligned(&pad[0], b, I, F);
+    if (a.sign == b.sign) buf[1] = char('0' + add_digits(&buf[2], pad.data(), I + F, false));
+    else sub_digits(&buf[2], pad.data(), I + F, false);
+
+    size_t dot = 2 + I, lo = 1, hi = buf.size();
+    while (lo < dot && buf[lo] == '0') ++lo;
+    while (hi > dot && buf[hi - 1] == '0') --hi;
+    buf[lo - 1] = '-';  // lets to_string copy a negative integer in one go
+    BigDecimalView r;
+    r.sign = a.sign;
+    std::string_view s(buf);
+    r.intPart = s.substr(lo, dot - lo);
+    r.fracPart = s.substr(dot, hi - dot);
+    r.contiguous = lo < dot && hi == dot;  // buf has no dot to copy across
+    return r;
+}
+
+void to_string(BigDecimalView v, string& out) {
+    // a literal already in canonical form is one copy of its input bytes
+    if (v.contiguous) {
+        const char* b = v.intPart.data() - (v.sign < 0);
+        const char* e = v.fracPart.empty() ? v.intPart.data() + v.intPart.size()
+                                           : v.fracPart.data() + v.fracPart.size();
+        out.append(b, e);
+        return;
+    }
+    if (v.sign < 0) out.push_back('-');
+    if (v.intPart.empty()) out.push_back('0');
+    else out += v.intPart;
+    if (!v.fracPart.empty()) {
+        out.push_back('.');
+        out += v.fracPart;
+    }
+}
+
+/* -------------------- FixedDecimal (--scale I.F) -------------------- */
+// load, add and format all run at compile time
+static_assert([] {
+    FixedDecimal<20, 4> a, b, r;
+    BigDecimalView x{-1, "12", "5"}, y{+1, "", "0125"};
+    char buf[32] = {};
+    return FixedDecimal<20, 4>::load(x, a) && FixedDecimal<20, 4>::load(y, b) &&
+           FixedDecimal<20, 4>::add(a, b, r) && r.format(buf) == 8 && buf[0] == '-' && buf[7] == '5';
+}(), "FixedDecimal is constexpr");
+
+/* -------------------- Columnar batch addition -------------------- */
+
+// Arena bytes laid out per block: the two arenas of a block stay in L2
+// while it is summed and copied out.
+constexpr size_t BATCH_BLOCK = 32 * 1024;
+
+bool add_batch(Span<BigDecimalView> a, Span<BigDecimalView> b, OutputBuffer& out) {
+    out.text.clear();
+    out.offsets.clear();
+    if (a.size() != b.size()) return false;
+    size_t n = a.size();
+    out.sign.resize(n);
+    out.I.resize(n);
+    out.F.resize(n);
+    out.row.resize(n);
+    out.offsets.resize(n + 1);
+    for (size_t first = 0, last = 0; first < n; first = last) {
+        // pass 1: columns for a block of rows (at least one), sized into its
+        // add and subtract groups; row holds the width until pass 2
+        size_t group[2] = {0, 0};
+        for (; last < n; ++last) {
+            size_t I = std::max(a[last].intPart.size(), b[last].intPart.size());
+            size_t F = std::max(a[last].fracPart.size(), b[last].fracPart.size());
+            if (last > first && group[0] + group[1] + 2 + I + F > BATCH_BLOCK) break;
+            bool sub = a[last].sign != b[last].sign;
+            int cmp = sub ? cmp_abs(a[last], b[last]) : 0;
+            out.sign[last] = int8_t(sub && cmp == 0 ? 0 : cmp < 0 ? b[last].sign : a[last].sign);
+            out.I[last] = uint32_t(I);
+            out.F[last] = uint32_t(F);
+            out.row[last] = out.sign[last] ? 2 + I + F : 0;
+            group[sub] += out.row[last];
+        }
+
+        // pass 2: rows, each group contiguous
+        out.arena.resize(group[0] + group[1]);
+        out.pad.resize(out.arena.size());
+        size_t next[2] = {0, group[0]};
+        for (size_t i = first; i < last; ++i) {
+            if (out.sign[i] == 0) continue;
+            bool sub = a[i].sign != b[i].sign;
+            bool swap = sub && out.sign[i] != a[i].sign;
+            size_t r = next[sub];
+            next[sub] += out.row[i];
+            out.row[i] = r;
+            std::memset(&out.arena[r], '0', 2);
+            std::memset(&out.pad[r], '0', 2);
+            put_aligned(&out.arena[r + 2], swap ? b[i] : a[i], out.I[i], out.F[i]);
+            put_aligned(&out.pad[r + 2], swap ? a[i] : b[i], out.I[i], out.F[i]);
+        }
+        add_digits(&out.arena[0], out.pad.data(), group[0], false);
+        sub_digits(&out.arena[group[0]], out.pad.data() + group[0], group[1], false);
+
+        // results in input order, trimmed as add_views does
+        std::string_view s(out.arena);
+        for (size_t i = first; i < last; ++i) {
+            out.offsets[i] = out.text.size();
+            if (out.sign[i] == 0) {
+                out.text.push_back('0');
+                continue;
+            }
+            size_t dot = out.row[i] + 2 + out.I[i], lo = out.row[i] + 1, hi = dot + out.F[i];
+            while (lo < dot && s[lo] == '0') ++lo;
+            while (hi > dot && s[hi - 1] == '0') --hi;
+            out.arena[lo - 1] = '-';
+            BigDecimalView v;
+            v.sign = out.sign[i];
+            v.intPart = s.substr(lo, dot - lo);
+            v.fracPart = s.substr(dot, hi - dot);
+            v.contiguous = lo < dot && hi == dot;
+            to_string(v, out.text);
+        }
+    }
+    out.offsets[n] = out.text.size();
+    return true;
+}
+
+/* -------------------- BigDecimalAccumulator (deferred carry) -------------------- */
+
+BigDecimal BigDecimalAccumulator::finish() const {
+    BigDecimalAccumulator t = *this;
+    t.carry();
+
+    BigDecimal r;
+    r.frac = t.frac_;
+    if (!t.lanes_.empty() && t.lanes_.back() < 0) {
+        // negative total: negate every lane and carry again for |total|
+        for (int64_t& v : t.lanes_) v = -v;
+        t.carry();
+        r.sign = -1;
+    }
+    r.limbs.assign(t.lanes_.begin(), t.lanes_.end());
+    if (r.limbs.size() < r.frac) r.limbs.resize(r.frac, 0);
+    normalize(r);
+    return r;
+}
+
+}  // namespace bigdecimal
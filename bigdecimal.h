@@ -0,0 +1,668 @@
+// BigDecimal core: exact arithmetic on decimal literals, built as
+// libbigdecimal (make lib). Everything is in namespace bigdecimal; calc's
+// driver (driver.cpp) and bench.cpp are its clients.
+#ifndef BIGDECIMAL_H
+#define BIGDECIMAL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bigdecimal {
+
+/* -------------------- Utilities -------------------- */
+
+// 128-bit integers (a GCC/Clang extension, hence the __extension__)
+__extension__ typedef unsigned __int128 u128;
+__extension__ typedef __int128 i128;
+
+/* -------------------- Run statistics -------------------- */
+/*
+   What the core counts for calc's --stats: literals scanned, why they were
+   rejected, their lengths, and limb blocks taken from a memory resource.
+   It adds to them only when it is itself built with -DCALC_STATS (make
+   calc-stats); nothing here depends on that flag, so any client links
+   against either build. Each thread counts into its own block, which is
+   folded into the total when the thread exits.
+*/
+
+struct Stats {
+    uint64_t tokens = 0;
+    uint64_t rejected[8] = {};     // indexed by ParseError
+    uint64_t lengthLog2[32] = {};  // literals by floor(log2(length))
+    uint64_t limbSpills = 0;       // LimbVector blocks taken from a resource
+
+    void merge(const Stats& o) {
+        tokens += o.tokens;
+        for (size_t i = 0; i < 8; ++i) rejected[i] += o.rejected[i];
+        for (size_t i = 0; i < 32; ++i) lengthLog2[i] += o.lengthLog2[i];
+        limbSpills += o.limbSpills;
+    }
+};
+
+// The calling thread's block.
+Stats& stats_local();
+
+// The blocks of threads that have exited plus the calling thread's.
+Stats stats_snapshot();
+
+/* -------------------- Validation -------------------- */
+/*
+   Valid double format (std::string only, no conversion):
+   Optional sign [+|-], then digits, optionally '.' with at least 1 digit on BOTH sides.
+   Allowed examples: "1", "1.0", "+1.0", "+0001.0", "-0001.005"
+   Disallowed examples: "A", "+-1", "-5.", "-.5", "-5.-5"
+*/
+
+// Why a literal was rejected (None when it is valid).
+enum class ParseError {
+    None,
+    Empty,         // ""
+    SignOnly,      // "+", "-"
+    NoIntDigits,   // "A", "+-1", "-.5"
+    NoFracDigits,  // "-5.", "-5.-5"
+    BadChar        // "1e5", "1.2.3"
+};
+
+// Validate x and report where its '.' is (npos for a pure integer).
+ParseError scan_double_literal(std::string_view x, size_t& dot);
+
+// scan_double_literal without the dot.
+bool is_valid_double_literal(std::string_view x);
+
+// Why a literal was rejected, as INVALID lines word it ("" for None).
+const char* parse_error_text(ParseError e);
+
+/* -------------------- BigDecimal (limb-based) -------------------- */
+/*
+   The magnitude is stored as base-10^9 limbs, least-significant limb first.
+   The lowest `frac` limbs hold the fractional digits, 9 per limb and padded
+   with zeros on the right, so the value is  sign * limbs * 10^(-9 * frac).
+   Decimal strings only exist at the I/O boundary (parse_normalize/to_string).
+*/
+
+constexpr uint32_t LIMB_BASE = 1000000000u;
+constexpr size_t LIMB_DIGITS = 9;
+
+// Limb storage with the first INLINE limbs (64 bytes, 144 digits) inside the
+// object, so short values never touch the allocator; longer ones spill to a
+// block from the memory resource (null means the global heap). Provides just
+// the std::vector operations BigDecimal uses. As with std::pmr containers,
+// copies use the global heap, moves keep the source's resource, and
+// assignment keeps the target's.
+//
+// The limbs need not start at the beginning of the block: erasing at the
+// front only advances data_, and inserting at the front reuses that room,
+// so trimming or widening the fraction costs nothing per kept limb.
+class LimbVector {
+public:
+    static constexpr size_t INLINE = 16;
+
+    LimbVector() = default;
+    explicit LimbVector(std::pmr::memory_resource* res) : res_(res) {}
+    LimbVector(const LimbVector& o) { assign(o.begin(), o.end()); }
+    LimbVector(LimbVector&& o) noexcept : res_(o.res_) { steal(o); }
+    LimbVector& operator=(const LimbVector& o) {
+        if (this != &o) assign(o.begin(), o.end());
+        return *this;
+    }
+    LimbVector& operator=(LimbVector&& o) noexcept {
+        if (this == &o) return *this;
+        if (o.res_ != res_) {
+            assign(o.begin(), o.end());  // a block from another resource cannot be adopted
+            return *this;
+        }
+        release();
+        steal(o);
+        return *this;
+    }
+    ~LimbVector() { release(); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint32_t* data() { return data_; }
+    const uint32_t* data() const { return data_; }
+    uint32_t* begin() { return data_; }
+    uint32_t* end() { return data_ + size_; }
+    const uint32_t* begin() const { return data_; }
+    const uint32_t* end() const { return data_ + size_; }
+    uint32_t& operator[](size_t i) { return data_[i]; }
+    uint32_t operator[](size_t i) const { return data_[i]; }
+    uint32_t& back() { return data_[size_ - 1]; }
+    uint32_t back() const { return data_[size_ - 1]; }
+
+    void clear() {
+        data_ = base_;
+        size_ = 0;
+    }
+    void pop_back() { --size_; }
+    void push_back(uint32_t v) {
+        if (size_ == room()) make_room(size_ + 1);
+        data_[size_++] = v;
+    }
+    void resize(size_t n, uint32_t v = 0) {
+        if (n > room()) make_room(n);
+        for (size_t i = size_; i < n; ++i) data_[i] = v;
+        size_ = n;
+    }
+    template <class It>
+    void assign(It first, It last) {
+        size_t n = size_t(last - first);
+        data_ = base_;
+        size_ = 0;
+        if (n > cap_) grow(n, 0);
+        std::copy(first, last, data_);
+        size_ = n;
+    }
+    uint32_t* insert(uint32_t* pos, size_t n, uint32_t v) {
+        size_t at = size_t(pos - data_);
+        if (at == 0 && size_t(data_ - base_) >= n) {
+            data_ -= n;  // into the room left by earlier front erases
+        } else {
+            if (size_ + n > room()) make_room(size_ + n);
+            std::memmove(data_ + at + n, data_ + at, (size_ - at) * sizeof(uint32_t));
+        }
+        std::fill(data_ + at, data_ + at + n, v);
+        size_ += n;
+        return data_ + at;
+    }
+    uint32_t* insert(uint32_t* pos, uint32_t v) { return insert(pos, 1, v); }
+    uint32_t* erase(uint32_t* first, uint32_t* last) {
+        size_t at = size_t(first - data_), n = size_t(last - first);
+        if (at == 0) data_ += n;  // leaves room for a later front insert
+        else std::memmove(first, last, size_t(end() - last) * sizeof(uint32_t));
+        size_ -= n;
+        return data_ + at;
+    }
+
+private:
+    bool onHeap() const { return base_ != inline_; }
+    // limbs that fit from data_ to the end of the block
+    size_t room() const { return cap_ - size_t(data_ - base_); }
+    std::pmr::memory_resource* resource() const {
+        return res_ ? res_ : std::pmr::new_delete_resource();
+    }
+    void release() {
+        if (onHeap()) resource()->deallocate(base_, cap_ * sizeof(uint32_t), alignof(uint32_t));
+        base_ = data_ = inline_;
+        cap_ = INLINE;
+        size_ = 0;
+    }
+    // take o's block (same resource), or copy its inline limbs; o is left empty
+    void steal(LimbVector& o) {
+        if (o.onHeap()) {
+            base_ = o.base_;
+            data_ = o.data_;
+            cap_ = o.cap_;
+        } else {
+            std::copy(o.begin(), o.end(), inline_);
+        }
+        size_ = o.size_;
+        o.base_ = o.data_ = o.inline_;
+        o.cap_ = INLINE;
+        o.size_ = 0;
+    }
+    // room for n limbs from data_: slide back to the start of the block when
+    // the front room alone covers it, otherwise grow
+    void make_room(size_t n) {
+        size_t front = size_t(data_ - base_);
+        if (n <= cap_ && (front >= cap_ / 2 || !onHeap())) {
+            std::memmove(base_, data_, size_ * sizeof(uint32_t));
+            data_ = base_;
+            return;
+        }
+        grow(n, size_);
+    }
+    // a block of at least n limbs, growing geometrically; keeps the first
+    // `keep`. Out of line, so the spill count follows the library's build.
+    void grow(size_t n, size_t keep);
+
+    std::pmr::memory_resource* res_ = nullptr;
+    uint32_t inline_[INLINE];
+    uint32_t* base_ = inline_;  // start of the block
+    uint32_t* data_ = inline_;  // first limb, at or after base_
+    size_t size_ = 0;
+    size_t cap_ = INLINE;       // block size in limbs
+};
+
+struct BigDecimal {
+    // sign: +1 or -1, zero uses +1 with no limbs.
+    int sign = +1;
+    LimbVector limbs;             // no zero limbs above the fraction
+    size_t frac = 0;              // fractional limbs; limbs[0] != 0 when frac > 0
+
+    BigDecimal() = default;
+    // limbs past the inline buffer come from res
+    explicit BigDecimal(std::pmr::memory_resource* res) : limbs(res) {}
+
+    bool isZero() const {
+        return limbs.empty();
+    }
+};
+
+/* -------------------- BigDecimalView (zero-copy) -------------------- */
+/*
+   Normalized digit spans into a literal's own text: no leading zeros in
+   intPart (empty means 0), no trailing zeros in fracPart. The view never
+   owns memory, so the literal must outlive it.
+
+   `contiguous` is set only by make_view and add_views, when the spans sit
+   in one canonical run of text: '-' right before a negative intPart, and
+   '.' between intPart and fracPart (or no fraction). to_string then copies
+   that run in one go; views built by hand print from the spans.
+*/
+
+struct BigDecimalView {
+    int sign = +1;
+    std::string_view intPart;
+    std::string_view fracPart;
+    bool contiguous = false;
+
+    bool isZero() const {
+        return intPart.empty() && fracPart.empty();
+    }
+};
+
+// Split a validated literal into normalized spans without copying.
+// `dot` is the offset reported by scan_double_literal (npos if none).
+BigDecimalView make_view(std::string_view x, size_t dot);
+
+// Assumes is_valid_double_literal(x) == true.
+BigDecimalView make_view(std::string_view x);
+
+// Compare |a| vs |b| straight from the text: integer length, then digits.
+int cmp_abs(BigDecimalView a, BigDecimalView b);
+
+// Load a view into r, reusing r's limb buffer.
+void assign(BigDecimal& r, BigDecimalView v);
+
+// Parse a validated literal into normalized BigDecimal.
+// `dot` is the offset reported by scan_double_literal (npos if none).
+BigDecimal parse_normalize(std::string_view x, size_t dot);
+
+// Assumes is_valid_double_literal(x) == true.
+BigDecimal parse_normalize(std::string_view x);
+
+// Validate and parse in one forward pass: each digit is checked as it is
+// packed into out's limbs, and the zero runs are dropped on the way. The
+// error is the one scan_double_literal would report; on an error out holds
+// a partial value.
+ParseError try_parse(std::string_view x, BigDecimal& out);
+
+/* -------------------- Limb arithmetic (in place) -------------------- */
+// r = a widened to at least F fractional limbs, the padding written as part of the copy
+inline void copy_widened(BigDecimal& r, const BigDecimal& a, size_t F) {
+    size_t d = (F > a.frac && !a.isZero()) ? F - a.frac : 0;  // zero stays empty
+    r.sign = a.sign;
+    r.frac = a.frac + d;
+    r.limbs.clear();
+    r.limbs.resize(d + a.limbs.size(), 0);
+    std::copy(a.limbs.begin(), a.limbs.end(), r.limbs.begin() + d);
+}
+
+// Compare |a| vs |b|. Return -1 if |a|<|b|, 0 if equal, +1 if |a|>|b|.
+int cmp_abs(const BigDecimal& a, const BigDecimal& b);
+
+// acc += rhs (with signs), reusing acc's buffer
+void add_into(BigDecimal& acc, const BigDecimal& rhs);
+
+// acc += rhs (with signs), splitting a long addition or subtraction over up
+// to `threads` threads
+void add_into(BigDecimal& acc, const BigDecimal& rhs, unsigned threads);
+
+// acc += rhs for a literal view; the limb scratch is reused across calls
+void add_into(BigDecimal& acc, BigDecimalView rhs);
+
+// Add absolute values: result is non-negative
+BigDecimal add_abs(const BigDecimal& a, const BigDecimal& b);
+
+// Subtract absolute values: |a| - |b|, negative when |b| > |a|. The sign
+// comes out of the subtraction itself, so callers need no cmp_abs first.
+BigDecimal sub_abs(const BigDecimal& a, const BigDecimal& b);
+
+// a + b (with signs)
+BigDecimal add_signed(const BigDecimal& a, const BigDecimal& b);
+
+// Single additions at least this many limbs long may be split across threads
+// (add_into with threads > 1); below it starting threads costs more than it
+// saves. The default is an estimate, not a measured crossover; see
+// bigdecimal.cpp and BM_add_parallel in bench.cpp.
+extern size_t par_add_threshold;
+
+/* -------------------- Multiplication -------------------- */
+// Crossovers of mul, in limbs of the shorter operand; BM_mul in bench.cpp
+// measures them.
+struct MulThresholds {
+    size_t karatsuba = 40;   // schoolbook below this many limbs
+    size_t toom3 = 600;      // Karatsuba below this
+    size_t ntt = 3000;       // Toom-3 below this (~27k digits)
+};
+extern MulThresholds mul_thresholds;
+
+// a * b (with signs); the product keeps every fractional digit.
+BigDecimal mul(const BigDecimal& a, const BigDecimal& b);
+
+/* -------------------- Rounding context -------------------- */
+/*
+   precision counts fractional digits. Rounding works on magnitudes, so
+   HalfUp means half away from zero and Truncate means toward zero.
+*/
+
+enum class RoundingMode { HalfEven, HalfUp, Truncate };
+
+struct DecimalContext {
+    size_t precision = SIZE_MAX;  // SIZE_MAX keeps every digit (exact)
+    RoundingMode rounding = RoundingMode::HalfEven;
+};
+
+// Round x in place to at most `digits` fractional digits.
+void round_to(BigDecimal& x, size_t digits, RoundingMode mode);
+
+// a + b (with signs), rounded to the context's precision
+BigDecimal add_signed(const BigDecimal& a, const BigDecimal& b, const DecimalContext& ctx);
+
+/* -------------------- Division -------------------- */
+// Divisor and quotient limbs from which div switches to Newton-Raphson
+// (BM_div in bench.cpp).
+extern size_t div_newton_threshold;
+
+// Digits a division keeps when its context is exact (SIZE_MAX)
+constexpr size_t DIV_DEFAULT_PRECISION = 20;
+
+// a / b rounded to `precision` fractional digits. b must be nonzero.
+BigDecimal div(const BigDecimal& a, const BigDecimal& b, size_t precision, RoundingMode mode);
+
+// Append the canonical text of x to out (no temporary string).
+void to_string(const BigDecimal& x, std::string& out);
+std::string to_string(const BigDecimal& x);
+
+/* -------------------- SmallDecimal (128-bit fast path) -------------------- */
+/*
+   Values with at most SMALL_MAX_DIGITS significant digits are held as
+   mant * 10^(-scale) in one signed 128-bit integer, so adding, multiplying
+   and comparing them is a handful of integer instructions. Every operation
+   reports overflow instead of wrapping; callers then promote to BigDecimal.
+   Like BigDecimal, a SmallDecimal is normalized: mant has no trailing zero
+   digit when scale > 0, and zero is mant 0, scale 0.
+*/
+
+constexpr size_t SMALL_MAX_DIGITS = 38;  // 10^38 - 1 < 2^127
+
+struct SmallDecimal {
+    i128 mant = 0;
+    uint32_t scale = 0;  // fractional digits
+};
+
+constexpr uint64_t POW10_U64[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull};
+
+// Load a view if it has at most SMALL_MAX_DIGITS digits; false leaves r untouched.
+bool assign(SmallDecimal& r, BigDecimalView v);
+
+// r = a + b; false (r unspecified) when the sum does not fit
+bool add_small(const SmallDecimal& a, const SmallDecimal& b, SmallDecimal& r);
+
+// r = a * b; false (r unspecified) when the product does not fit
+bool mul_small(const SmallDecimal& a, const SmallDecimal& b, SmallDecimal& r);
+
+// Compare |a| vs |b|. Return -1 if |a|<|b|, 0 if equal, +1 if |a|>|b|.
+int cmp_abs(const SmallDecimal& a, const SmallDecimal& b);
+
+// Promote to the limb representation.
+void assign(BigDecimal& r, const SmallDecimal& x);
+
+// Append the canonical text of x to out, matching to_string(BigDecimal).
+void to_string(const SmallDecimal& x, std::string& out);
+
+/* -------------------- ASCII digit path -------------------- */
+// a + b as a normalized view into buf; pad is scratch. Both buffers are
+// reused from call to call and must outlive the returned view.
+BigDecimalView add_views(BigDecimalView a, BigDecimalView b, std::string& buf, std::string& pad);
+
+// Append the canonical text of v to out, matching to_string(BigDecimal).
+void to_string(BigDecimalView v, std::string& out);
+
+/* -------------------- FixedDecimal (--scale I.F) -------------------- */
+/*
+   Values of a known schema, at most I integer and F fractional digits,
+   held as one integer scaled by 10^F: 64 bits while I + F <= 18, else 128.
+   Loading, adding and formatting are constexpr with loop bounds fixed by
+   the template, so they unroll. A literal outside the schema, or a sum
+   that leaves it, is reported so the caller can fall back to the general
+   paths. Literals are validated by scan_double_literal before they get
+   here, so the rules are the same as everywhere else.
+
+   The batch adder works on structure-of-arrays blocks of FIXED_BATCH
+   cases, one array per operand and one for the sums, and leaves the range
+   check to the caller, so the loop over cases vectorizes (64-bit forms).
+*/
+
+constexpr size_t FIXED_BATCH = 256;      // cases per batch
+constexpr unsigned FIXED_MAX_FRAC = 18;  // largest F offered by --scale
+
+template <unsigned I, unsigned F>
+struct FixedDecimal {
+    static constexpr unsigned N = I + F;
+    static_assert(N >= 1 && N <= 37, "FixedDecimal holds 1..37 digits (a sum of two must fit in 128 bits)");
+    static_assert(F <= FIXED_MAX_FRAC, "the fraction is handled in 64 bits");
+    using Rep = std::conditional_t<(N <= 18), int64_t, i128>;
+    using URep = std::conditional_t<(N <= 18), uint64_t, u128>;
+
+    static constexpr Rep pow10(unsigned n) {
+        Rep p = 1;
+        for (unsigned k = 0; k < n; ++k) p *= 10;
+        return p;
+    }
+    static constexpr Rep LIMIT = pow10(N);  // |v| < LIMIT
+
+    Rep v = 0;  // value * 10^F
+
+    // Load a normalized view; false if it has more than I integer or F
+    // fractional digits.
+    static constexpr bool load(BigDecimalView x, FixedDecimal& r) {
+        size_t ni = x.intPart.size(), nf = x.fracPart.size();
+        if (ni > I || nf > F) return false;
+        // integer digits in 64-bit pieces of up to 18, then exactly F
+        // fraction digits (a fixed-length, unrolled loop)
+        URep m = 0;
+        for (size_t k = 0, n = ni % 18 ? ni % 18 : 18; k < ni; n = 18) {
+            uint64_t piece = 0;
+            for (size_t e = k + n; k < e; ++k) piece = piece * 10 + uint64_t(x.intPart[k] - '0');
+            m = m * POW10_U64[n] + piece;
+        }
+        uint64_t f = 0;
+        for (unsigned k = 0; k < F; ++k) f = f * 10 + uint64_t(k < nf ? x.fracPart[k] - '0' : 0);
+        m = m * POW10_U64[F] + f;
+        r.v = x.sign < 0 ? -Rep(m) : Rep(m);
+        return true;
+    }
+
+    // Whether a sum of two in-schema values still fits the schema
+    static constexpr bool in_range(Rep s) { return s < LIMIT && s > -LIMIT; }
+
+    // r = a + b; false if the sum needs more than I integer digits.
+    static constexpr bool add(FixedDecimal a, FixedDecimal b, FixedDecimal& r) {
+        r.v = a.v + b.v;
+        return in_range(r.v);
+    }
+
+    // r[i] = a[i] + b[i] over a whole block (unused lanes hold zeros). The
+    // trip count is fixed and nothing aliases, so it vectorizes at -O2.
+    static void add_batch(const Rep* __restrict a, const Rep* __restrict b, Rep* __restrict r) {
+        for (size_t i = 0; i < FIXED_BATCH; ++i) r[i] = a[i] + b[i];
+    }
+
+    // The canonical text, as to_string(BigDecimal) writes it, into buf
+    // (at least N + 3 bytes). Returns its length.
+    constexpr size_t format(char* buf) const {
+        char t[N + 2] = {};  // built from the back
+        size_t p = N + 2;
+        URep m = v < 0 ? URep(0) - URep(v) : URep(v);
+        URep ip = m / POW10_U64[F];
+        uint64_t fp = uint64_t(m - ip * POW10_U64[F]);
+        bool digits = false;  // a nonzero fraction digit has been written
+        for (unsigned k = 0; k < F; ++k) {
+            char d = char('0' + fp % 10);
+            fp /= 10;
+            digits = digits || d != '0';
+            if (digits) t[--p] = d;
+        }
+        if (digits) t[--p] = '.';
+        // 64-bit digit loops; a wide integer part is split once at 10^18
+        uint64_t lo = uint64_t(ip), hi = 0;
+        if constexpr (N > 18) {
+            hi = uint64_t(ip / POW10_U64[18]);
+            lo = uint64_t(ip - URep(hi) * POW10_U64[18]);
+        }
+        if (hi) {
+            for (unsigned k = 0; k < 18; ++k) { t[--p] = char('0' + lo % 10); lo /= 10; }
+            for (; hi; hi /= 10) t[--p] = char('0' + hi % 10);
+        } else {
+            do { t[--p] = char('0' + lo % 10); lo /= 10; } while (lo);
+        }
+        size_t n = 0;
+        if (v < 0) buf[n++] = '-';
+        for (; p < N + 2; ++p) buf[n++] = t[p];
+        return n;
+    }
+};
+
+/* -------------------- Columnar batch addition -------------------- */
+/*
+   add_batch sums n pairs of views in one call for code that links the core.
+   The pairs are taken in blocks of about BATCH_BLOCK arena bytes. Pass 1
+   fills a block's columns (result sign, grid I and F, row width) and sorts
+   it into an add group and a subtract group; pass 2 lays every row out in
+   two contiguous digit arenas as [0][0][I.F grid]. A row's carry (or, with the
+   larger magnitude on top, its borrow) ends in its own two leading zeros, so
+   one kernel call covers a whole group with no per-pair setup. The block's
+   results are then copied out in input order, back to back.
+*/
+
+// Read-only run of n Ts (std::span is C++20).
+template <class T>
+struct Span {
+    const T* ptr = nullptr;
+    size_t len = 0;
+
+    Span() = default;
+    Span(const T* p, size_t n) : ptr(p), len(n) {}
+    template <class C, class = decltype(std::declval<const C&>().data())>
+    Span(const C& c) : ptr(c.data()), len(c.size()) {}
+
+    size_t size() const { return len; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + len; }
+};
+
+// Results of add_batch: result i is text[offsets[i], offsets[i + 1]). The
+// columns and arenas are scratch kept from call to call.
+struct OutputBuffer {
+    std::string text;
+    std::vector<size_t> offsets;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::string_view operator[](size_t i) const {
+        return std::string_view(text).substr(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    std::vector<int8_t> sign;        // result sign, 0 for a zero sum
+    std::vector<uint32_t> I, F;      // grid of pair i
+    std::vector<size_t> row;         // offset of pair i's row in the arenas
+    std::string arena, pad;          // larger resp. smaller magnitudes
+};
+
+// a[i] + b[i] for every i, replacing out's results. False (and no results)
+// when a and b differ in length.
+bool add_batch(Span<BigDecimalView> a, Span<BigDecimalView> b, OutputBuffer& out);
+
+/* -------------------- BigDecimalAccumulator (deferred carry) -------------------- */
+/*
+   Signed 64-bit lanes on the same base-10^9 / `frac` grid as BigDecimal.
+   add() just adds or subtracts each limb into its lane, with no carries and
+   no magnitude compare, so mixed signs cost the same as equal ones. A lane
+   never exceeds (pending + 1) * 10^9, so carries are propagated only every
+   CARRY_INTERVAL additions and when the value is read back with finish().
+*/
+
+class BigDecimalAccumulator {
+public:
+    static constexpr uint64_t CARRY_INTERVAL = uint64_t(1) << 32;
+
+    void add(const BigDecimal& x) {
+        if (x.isZero()) return;
+        widen(x.frac);
+        size_t d = frac_ - x.frac;
+        if (lanes_.size() < x.limbs.size() + d) lanes_.resize(x.limbs.size() + d, 0);
+
+        int64_t* lane = lanes_.data() + d;
+        if (x.sign > 0) for (size_t i = 0; i < x.limbs.size(); ++i) lane[i] += x.limbs[i];
+        else            for (size_t i = 0; i < x.limbs.size(); ++i) lane[i] -= x.limbs[i];
+        if (++pending_ >= CARRY_INTERVAL) carry();
+    }
+
+    // Absorb another accumulator's total.
+    void merge(const BigDecimalAccumulator& o) {
+        widen(o.frac_);
+        size_t d = frac_ - o.frac_;
+        if (lanes_.size() < o.lanes_.size() + d) lanes_.resize(o.lanes_.size() + d, 0);
+        for (size_t i = 0; i < o.lanes_.size(); ++i) lanes_[i + d] += o.lanes_[i];
+        pending_ += o.pending_ + 1;
+        if (pending_ >= CARRY_INTERVAL) carry();
+    }
+
+    // The exact total as a normalized BigDecimal.
+    BigDecimal finish() const;
+
+private:
+    // Give the lanes at least F fractional limbs. The fraction grows at least
+    // twofold each time, so a stream of ever-longer fractions shifts the lanes
+    // only O(log) times; the extra zero limbs are trimmed by finish().
+    void widen(size_t F) {
+        if (F <= frac_) return;
+        F = std::max(F, 2 * frac_);
+        lanes_.insert(lanes_.begin(), F - frac_, 0);
+        frac_ = F;
+    }
+
+    // Bring every lane into [0, 10^9); only the top lane keeps a sign, in (-10^9, 10^9).
+    void carry() {
+        const int64_t B = LIMB_BASE;
+        int64_t c = 0;
+        for (int64_t& v : lanes_) {
+            int64_t t = v + c;
+            c = t / B;
+            t %= B;
+            if (t < 0) { t += B; --c; }
+            v = t;
+        }
+        while (c >= B || c <= -B) {
+            int64_t t = c % B;
+            c /= B;
+            if (t < 0) { t += B; --c; }
+            lanes_.push_back(t);
+        }
+        if (c != 0) lanes_.push_back(c);
+        while (lanes_.size() > frac_ && lanes_.back() == 0) lanes_.pop_back();
+        pending_ = 0;
+    }
+
+    std::vector<int64_t> lanes_;
+    size_t frac_ = 0;
+    uint64_t pending_ = 0;  // additions since the last carry pass
+};
+
+}  // namespace bigdecimal
+
+#endif  // BIGDECIMAL_H
@@ -0,0 +1,834 @@
+// Differential check of the arithmetic core and calc's driver against slow
+// digit-string references. Build and run it with `make check`; it links the
+// driver and the library only, so it needs nothing Google Benchmark does.
+
+#include "bigdecimal.h"
+#include "driver.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace bigdecimal;
+using namespace calc;
+
+/* -------------------- Original implementation -------------------- */
+/*
+   The string-based BigDecimal of the first Lab10.cpp (the baseline commit),
+   copied unchanged: one decimal digit per char, no fast paths. It is the
+   reference every add path is checked against.
+*/
+
+namespace original {
+
+using std::string;
+
+static inline void trim_leading_zeros(string& s) {
+    size_t i = 0;
+    while (i + 1 < s.size() && s[i] == '0') ++i;
+    if (i > 0) s.erase(0, i);
+}
+
+static inline void trim_trailing_zeros(string& s) {
+    // for fractional part only
+    while (!s.empty() && s.back() == '0') s.pop_back();
+}
+
+/* -------------------- BigDecimal (string-based) -------------------- */
+
+struct BigDecimal {
+    // sign: +1 or -1, zero uses +1 with "0" and empty frac.
+    int sign = +1;
+    string intPart = "0";   // no leading zeros except single "0"
+    string fracPart = "";   // no trailing zeros; empty means no decimal
+
+    bool isZero() const {
+        return intPart == "0" && fracPart.empty();
+    }
+};
+
+// Parse a validated literal into normalized BigDecimal.
+// Assumes is_valid_double_literal(x) == true.
+BigDecimal parse_normalize(const string& x) {
+    BigDecimal r;
+    size_t i = 0;
+
+    if (x[i] == '+') { r.sign = +1; ++i; }
+    else if (x[i] == '-') { r.sign = -1; ++i; }
+
+    // split on dot if present
+    size_t dot = x.find('.', i);
+    if (dot == string::npos) {
+        r.intPart = x.substr(i);
+        r.fracPart.clear();
+    } else {
+        r.intPart = x.substr(i, dot - i);
+        r.fracPart = x.substr(dot + 1);
+    }
+
+    // normalize integer part: remove leading zeros
+    trim_leading_zeros(r.intPart);
+    // normalize fractional part: remove trailing zeros
+    trim_trailing_zeros(r.fracPart);
+
+    // if all becomes zero -> sign should be + and represent canonical zero
+    if (r.intPart == "0" && r.fracPart.empty()) {
+        r.sign = +1;
+    }
+
+    return r;
+}
+
+// Align fractional lengths by padding right with zeros as needed
+static inline void align_frac(BigDecimal& a, BigDecimal& b) {
+    size_t L = std::max(a.fracPart.size(), b.fracPart.size());
+    a.fracPart.append(L - a.fracPart.size(), '0');
+    b.fracPart.append(L - b.fracPart.size(), '0');
+}
+
+// Compare |a| vs |b|. Return -1 if |a|<|b|, 0 if equal, +1 if |a|>|b|.
+int cmp_abs(BigDecimal a, BigDecimal b) {
+    align_frac(a, b);
+
+    // compare integer length
+    if (a.intPart.size() != b.intPart.size())
+        return (a.intPart.size() < b.intPart.size()) ? -1 : +1;
+
+    // compare integer lexicographically
+    if (a.intPart != b.intPart)
+        return (a.intPart < b.intPart) ? -1 : +1;
+
+    // compare fraction lexicographically
+    if (a.fracPart != b.fracPart)
+        return (a.fracPart < b.fracPart) ? -1 : +1;
+
+    return 0;
+}
+
+// Add absolute values: result is non-negative
+BigDecimal add_abs(BigDecimal a, BigDecimal b) {
+    align_frac(a, b);
+    BigDecimal r;
+    r.sign = +1;
+
+    // add fractional part
+    int carry = 0;
+    r.fracPart.resize(a.fracPart.size());
+    for (int i = static_cast<int>(a.fracPart.size()) - 1; i >= 0; --i) {
+        int da = a.fracPart[i] - '0';
+        int db = b.fracPart[i] - '0';
+        int s = da + db + carry;
+        r.fracPart[i] = char('0' + (s % 10));
+        carry = s / 10;
+    }
+    trim_trailing_zeros(r.fracPart);
+
+    // add integer part
+    string A = a.intPart, B = b.intPart;
+    // left-pad shorter integer with zeros
+    if (A.size() < B.size()) A.insert(0, B.size() - A.size(), '0');
+    if (B.size() < A.size()) B.insert(0, A.size() - B.size(), '0');
+
+    string s(A.size(), '0');
+    for (int i = static_cast<int>(A.size()) - 1; i >= 0; --i) {
+        int da = A[i] - '0';
+        int db = B[i] - '0';
+        int sum = da + db + carry;
+        s[i] = char('0' + (sum % 10));
+        carry = sum / 10;
+    }
+    if (carry) s.insert(s.begin(), char('0' + carry));
+
+    // normalize intPart
+    r.intPart = s;
+    trim_leading_zeros(r.intPart);
+
+    return r;
+}
+
+// Subtract absolute values: assumes |a| >= |b|. Returns non-negative result = |a|-|b|.
+BigDecimal sub_abs(BigDecimal a, BigDecimal b) {
+    align_frac(a, b);
+    BigDecimal r;
+    r.sign = +1;
+
+    // subtract fractional part
+    int borrow = 0;
+    r.fracPart.resize(a.fracPart.size());
+    for (int i = static_cast<int>(a.fracPart.size()) - 1; i >= 0; --i) {
+        int da = a.fracPart[i] - '0' - borrow;
+        int db = b.fracPart[i] - '0';
+        if (da < db) { da += 10; borrow = 1; } else borrow = 0;
+        r.fracPart[i] = char('0' + (da - db));
+    }
+    trim_trailing_zeros(r.fracPart);
+
+    // subtract integer part
+    string A = a.intPart, B = b.intPart;
+    if (A.size() < B.size()) A.insert(0, B.size() - A.size(), '0');
+    if (B.size() < A.size()) B.insert(0, A.size() - B.size(), '0');
+
+    string s(A.size(), '0');
+    for (int i = static_cast<int>(A.size()) - 1; i >= 0; --i) {
+        int da = A[i] - '0' - borrow;
+        int db = B[i] - '0';
+        if (da < db) { da += 10; borrow = 1; } else borrow = 0;
+        s[i] = char('0' + (da - db));
+    }
+
+    // remove leading zeros
+    trim_leading_zeros(s);
+    if (s == "0" && r.fracPart.empty()) {
+        r.sign = +1;
+        r.intPart = "0";
+    } else {
+        r.intPart = s;
+    }
+    return r;
+}
+
+// a + b (with signs)
+BigDecimal add_signed(BigDecimal a, BigDecimal b) {
+    if (a.isZero()) return b;
+    if (b.isZero()) return a;
+
+    if (a.sign == b.sign) {
+        BigDecimal r = add_abs(a, b);
+        r.sign = a.sign;
+        if (r.isZero()) r.sign = +1;
+        return r;
+    } else {
+        // opposite signs => subtraction by larger magnitude
+        int cmp = cmp_abs(a, b);
+        if (cmp == 0) {
+            return BigDecimal{+1, "0", ""};
+        } else if (cmp > 0) {
+            BigDecimal r = sub_abs(a, b);
+            r.sign = a.sign;
+            if (r.isZero()) r.sign = +1;
+            return r;
+        } else {
+            BigDecimal r = sub_abs(b, a);
+            r.sign = b.sign;
+            if (r.isZero()) r.sign = +1;
+            return r;
+        }
+    }
+}
+
+string to_string(const BigDecimal& x) {
+    if (x.isZero()) return "0";
+    string out;
+    if (x.sign < 0) out.push_back('-');
+    out += x.intPart;
+    if (!x.fracPart.empty()) {
+        out.push_back('.');
+        out += x.fracPart;
+    }
+    return out;
+}
+
+}  // namespace original
+
+/* -------------------- Reference arithmetic -------------------- */
+/*
+   Products, quotients and rounding have no original to compare with, so
+   they get textbook references on Ref (decimal digits plus a scale). Every
+   result, ref_add's included, comes out in to_string's canonical form and
+   is compared as text.
+*/
+
+// The exact sum of two valid literals, by the original adder.
+static string ref_add(const string& x, const string& y) {
+    return original::to_string(original::add_signed(original::parse_normalize(x), original::parse_normalize(y)));
+}
+
+// sign * digits / 10^scale; digits has no leading zeros ("" is zero)
+struct Ref {
+    bool neg = false;
+    string digits;
+    size_t scale = 0;
+};
+
+static string strip(string d) {
+    d.erase(0, std::min(d.find_first_not_of('0'), d.size()));
+    return d;
+}
+
+static Ref ref_parse(const string& s) {
+    Ref r;
+    size_t p = 0;
+    if (s[p] == '+' || s[p] == '-') r.neg = s[p++] == '-';
+    size_t dot = s.find('.', p);
+    r.digits = s.substr(p, dot == string::npos ? string::npos : dot - p);
+    if (dot != string::npos) {
+        r.digits += s.substr(dot + 1);
+        r.scale = s.size() - dot - 1;
+    }
+    r.digits = strip(r.digits);
+    return r;
+}
+
+static string ref_text(const Ref& r) {
+    string d = r.digits;
+    if (d.size() <= r.scale) d.insert(0, r.scale + 1 - d.size(), '0');
+    string ip = strip(d.substr(0, d.size() - r.scale)), fp = d.substr(d.size() - r.scale);
+    fp.erase(fp.find_last_not_of('0') + 1);
+    if (ip.empty() && fp.empty()) return "0";
+    return (r.neg ? "-" : "") + (ip.empty() ? "0" : ip) + (fp.empty() ? "" : "." + fp);
+}
+
+// Digit strings without leading zeros, compared and combined as naturals
+static int dcmp(const string& a, const string& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    return a.compare(b) < 0 ? -1 : a.compare(b) > 0 ? 1 : 0;
+}
+
+static string dadd(const string& a, const string& b) {
+    string r(std::max(a.size(), b.size()) + 1, '0');
+    int carry = 0;
+    for (size_t k = 0; k + 1 < r.size() || carry; ++k) {
+        int s = carry + (k < a.size() ? a[a.size() - 1 - k] - '0' : 0) + (k < b.size() ? b[b.size() - 1 - k] - '0' : 0);
+        r[r.size() - 1 - k] = char('0' + s % 10);
+        carry = s / 10;
+    }
+    return strip(r);
+}
+
+// a - b for a >= b
+static string dsub(const string& a, const string& b) {
+    string r = a;
+    int borrow = 0;
+    for (size_t k = 0; k < a.size(); ++k) {
+        int s = (a[a.size() - 1 - k] - '0') - (k < b.size() ? b[b.size() - 1 - k] - '0' : 0) - borrow;
+        borrow = s < 0;
+        r[a.size() - 1 - k] = char('0' + s + 10 * borrow);
+    }
+    return strip(r);
+}
+
+static string dmul(const string& a, const string& b) {
+    if (a.empty() || b.empty()) return "";
+    std::vector<uint64_t> col(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j) col[i + j + 1] += uint64_t(a[i] - '0') * uint64_t(b[j] - '0');
+    string r(col.size(), '0');
+    uint64_t carry = 0;
+    for (size_t k = col.size(); k-- > 0;) {
+        uint64_t s = col[k] + carry;
+        r[k] = char('0' + s % 10);
+        carry = s / 10;
+    }
+    return strip(r);
+}
+
+// Long division, one quotient digit at a time, for b nonzero
+static void ddivmod(const string& a, const string& b, string& q, string& r) {
+    q.clear();
+    r.clear();
+    for (char c : a) {
+        r = strip(r + c);
+        char digit = '0';
+        while (dcmp(r, b) >= 0) {
+            r = dsub(r, b);
+            ++digit;
+        }
+        q.push_back(digit);
+    }
+    q = strip(q);
+}
+
+// Rounding a magnitude: vsHalf compares what is dropped with half a unit
+static bool round_up(RoundingMode mode, int vsHalf, bool dropped, const string& kept) {
+    bool odd = !kept.empty() && (kept.back() - '0') % 2 == 1;
+    switch (mode) {
+    case RoundingMode::HalfUp: return dropped && vsHalf >= 0;
+    case RoundingMode::HalfEven: return vsHalf > 0 || (vsHalf == 0 && odd);
+    case RoundingMode::Truncate: return false;
+    }
+    return false;
+}
+
+static string ref_mul(const string& x, const string& y) {
+    Ref a = ref_parse(x), b = ref_parse(y), r;
+    r.neg = a.neg != b.neg;
+    r.digits = dmul(a.digits, b.digits);
+    r.scale = a.scale + b.scale;
+    return ref_text(r);
+}
+
+// x rounded to p fractional digits
+static string ref_round(const string& x, size_t p, RoundingMode mode) {
+    Ref r = ref_parse(x);
+    if (r.scale <= p) return ref_text(r);
+    size_t drop = r.scale - p;
+    string d = r.digits;
+    if (d.size() <= drop) d.insert(0, drop + 1 - d.size(), '0');
+    string kept = strip(d.substr(0, d.size() - drop)), tail = d.substr(d.size() - drop);
+    bool dropped = tail.find_first_not_of('0') != string::npos;
+    bool sticky = tail.find_first_not_of('0', 1) != string::npos;
+    int vsHalf = tail[0] < '5' ? -1 : tail[0] > '5' ? 1 : sticky ? 1 : 0;
+    r.digits = round_up(mode, vsHalf, dropped, kept) ? dadd(kept, "1") : kept;
+    r.scale = p;
+    return ref_text(r);
+}
+
+// x / y (y nonzero) rounded to p fractional digits, as div does
+static string ref_div(const string& x, const string& y, size_t p, RoundingMode mode) {
+    if (p == SIZE_MAX) p = DIV_DEFAULT_PRECISION;
+    Ref a = ref_parse(x), b = ref_parse(y), r;
+    // x / y = a.digits 10^(b.scale + p) / (b.digits 10^a.scale) units of 10^-p
+    string q, rem, A = a.digits.empty() ? "" : a.digits + string(b.scale + p, '0');
+    ddivmod(A, b.digits + string(a.scale, '0'), q, rem);
+    int vsHalf = dcmp(dadd(rem, rem), b.digits + string(a.scale, '0'));
+    r.neg = a.neg != b.neg;
+    r.digits = round_up(mode, vsHalf, !rem.empty(), q) ? dadd(q, "1") : q;
+    r.scale = p;
+    return ref_text(r);
+}
+
+/* -------------------- Inputs -------------------- */
+
+// A valid literal: optional sign and zero padding, digits random or in runs;
+// now and then up to `longest` digits on either side of the dot.
+static string fuzz_literal(std::mt19937& rng, size_t longest = 20000) {
+    auto digits = [&](size_t n) {
+        string s;
+        unsigned style = rng() % 4;  // random, 9s, 0s, runs of either
+        for (size_t k = 0; k < n; ++k) {
+            char c = char('0' + rng() % 10);
+            if (style == 1 || (style == 3 && (k / 7) % 2)) c = '9';
+            if (style == 2 || (style == 3 && !((k / 7) % 2))) c = '0';
+            if (rng() % 16 == 0) c = char('0' + rng() % 10);
+            s.push_back(c);
+        }
+        return s;
+    };
+    auto length = [&] {
+        unsigned r = rng() % 64;
+        return r == 0 ? size_t(rng() % longest) : r < 4 ? size_t(rng() % std::min<size_t>(600, longest))
+                                                        : size_t(rng() % 24);
+    };
+    const char* sign[] = {"", "", "-", "+"};
+    string s = sign[rng() % 4];
+    if (rng() % 8 == 0) s.append(rng() % 4, '0');
+    string i = digits(length());
+    s += i.empty() ? "0" : i;
+    if (rng() % 3) {
+        string f = digits(length());
+        s += "." + (f.empty() ? "0" : f);
+        if (rng() % 8 == 0) s.append(rng() % 4, '0');
+    }
+    return s;
+}
+
+static bool is_zero(const string& literal) { return ref_parse(literal).digits.empty(); }
+
+// A scratch file holding text; the caller removes it.
+static string scratch_file(const string& text) {
+    char tmpl[] = "/tmp/calc_check_XXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd >= 0) ::close(fd);
+    std::ofstream(tmpl) << text;
+    return string(tmpl);
+}
+
+// What a run writes, through an OutputSink on a scratch file.
+template <class Run>
+static string capture(Run run) {
+    char tmpl[] = "/tmp/calc_check_XXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd < 0) return "<no scratch file>";
+    {
+        OutputSink sink(fd);
+        run(sink);
+    }
+    ::close(fd);
+    std::ifstream in(tmpl);
+    string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::remove(tmpl);
+    return text;
+}
+
+// The records of a --format binary run, written out as sum-only text.
+static string decode_binary(const string& bin) {
+    auto le32 = [&](size_t at) {
+        uint32_t v = 0;
+        for (size_t k = 4; k-- > 0;) v = v << 8 | uint8_t(bin[at + k]);
+        return v;
+    };
+    string text;
+    for (size_t p = 0; p < bin.size();) {
+        if (p + 5 > bin.size()) return text + "<truncated>\n";
+        size_t len = le32(p), r = p + 4;
+        p = r + len;
+        if (len == 0 || p > bin.size()) return text + "<truncated>\n";
+        if (bin[r] != 0) {
+            text += len == 1 ? "INVALID\n" : "<bad invalid record>\n";
+            continue;
+        }
+        uint32_t n = len >= 10 ? le32(r + 6) : 0;
+        if (len != 10 + size_t(4) * n) return text + "<bad record length>\n";
+        Ref v;
+        v.neg = int8_t(bin[r + 1]) < 0;
+        for (size_t k = n; k-- > 0;) {
+            char limb[16];
+            std::snprintf(limb, sizeof limb, "%09u", unsigned(le32(r + 10 + 4 * k)));
+            v.digits += limb;
+        }
+        int32_t e = int32_t(le32(r + 2));
+        if (e < 0) v.scale = size_t(-int64_t(e)) * LIMB_DIGITS;
+        else v.digits.append(size_t(e) * LIMB_DIGITS, '0');
+        v.digits = strip(v.digits);
+        text += ref_text(v) + '\n';
+    }
+    return text;
+}
+
+// Damage every cached slot in the table at path: overrun lengths, or a
+// value byte changed as a run killed mid-insert leaves it; returns how many
+// slots it hit.
+static size_t corrupt_cache(const string& path) {
+    size_t bytes = sizeof(CacheHeader) + CACHE_SETS * sizeof(CacheSet), hit = 0;
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0) return 0;
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return 0;
+    CacheSet* sets = reinterpret_cast<CacheSet*>(static_cast<CacheHeader*>(p) + 1);
+    for (size_t s = 0; s < CACHE_SETS; ++s)
+        for (size_t w = 0; w < CACHE_WAYS; ++w) {
+            if (!sets[s].stamp[w]) continue;
+            CacheSlot& e = sets[s].slot[w];
+            switch (hit++ % 3) {
+            case 0: e.keyLen = uint16_t(sizeof e.data); break;
+            case 1: e.valLen = uint16_t(sizeof e.data - e.keyLen + 1); break;
+            default: e.data[e.keyLen] ^= 0x10; break;  // '0'..'9' stay digits
+            }
+        }
+    munmap(p, bytes);
+    return hit;
+}
+
+/* -------------------- Check -------------------- */
+/*
+   Fuzzed literals, heavy on runs of 9s and 0s so carries and borrows travel
+   far. Every pair goes through add_signed, add_views, add_small, add_batch
+   and the threaded add_into, and each literal through try_parse and
+   round_to. Products go through mul with its thresholds forced onto each
+   algorithm in turn, quotients through div with Knuth D and with Newton.
+   The same literals, written out as files, go through the --sum paths and
+   the pair modes (serial, -j, --pipeline, --scale, --cache, binary output).
+*/
+
+namespace {
+
+struct Checker {
+    size_t cases = 0, bad = 0;
+
+    void expect(const char* what, const string& got, const string& want, const string& a, const string& b) {
+        ++cases;
+        if (got == want) return;
+        if (bad++ < 10)
+            std::fprintf(stderr, "check: %s mismatch for (%.60s, %.60s)\n  got  %.80s\n  want %.80s\n", what,
+                         a.c_str(), b.c_str(), got.c_str(), want.c_str());
+    }
+};
+
+// Pair-mode output of one run over the pair file at path
+string pair_run(const string& path, const PairOptions& opt, int mode) {
+    return capture([&](OutputSink& sink) {
+        InputReader in;
+        if (!in.open(path)) return;
+        if (mode == 0) run_pairs(in, sink, opt);
+        else if (mode == 1) run_pairs_parallel(in.mapped(), 3, sink, opt);
+        else run_pairs_pipelined(in, sink, opt);
+    });
+}
+
+}  // namespace
+
+static void check_add(Checker& ck, std::mt19937& rng) {
+    size_t saved = par_add_threshold;
+    OutputBuffer batch;
+    std::vector<string> ta, tb, want;
+    string pairText, sumText, pairWant, total = "0";
+    size_t invalid = 0;
+    for (int round = 0; round < 40; ++round) {
+        // every other round splits even the shortest add_into across threads
+        par_add_threshold = round % 2 ? saved : 0;
+        ta.clear();
+        tb.clear();
+        want.clear();
+        for (int k = 0; k < 500; ++k) {
+            ta.push_back(fuzz_literal(rng));
+            // a negated copy or a near neighbour of a cancels down to its tail
+            switch (rng() % 6) {
+            case 0: {
+                const string& a = ta.back();
+                tb.push_back(a[0] == '-' ? a.substr(1) : "-" + a.substr(a[0] == '+'));
+                break;
+            }
+            case 1: tb.push_back(ref_add(ta.back(), rng() % 2 ? "-0.000001" : "1")); break;
+            default: tb.push_back(fuzz_literal(rng));
+            }
+            want.push_back(ref_add(ta.back(), tb.back()));
+        }
+        std::vector<BigDecimalView> va, vb;
+        string buf, pad;
+        for (size_t k = 0; k < ta.size(); ++k) {
+            const string &a = ta[k], &b = tb[k];
+            va.push_back(make_view(a));
+            vb.push_back(make_view(b));
+            BigDecimal A = parse_normalize(a), B = parse_normalize(b);
+            ck.expect("add_signed", to_string(add_signed(A, B)), want[k], a, b);
+            string s;
+            to_string(add_views(va[k], vb[k], buf, pad), s);
+            ck.expect("add_views", s, want[k], a, b);
+            SmallDecimal x, y, r;
+            if (assign(x, va[k]) && assign(y, vb[k]) && add_small(x, y, r)) {
+                s.clear();
+                to_string(r, s);
+                ck.expect("add_small", s, want[k], a, b);
+            }
+            BigDecimal acc = A;
+            add_into(acc, B, 4);
+            ck.expect("add_into (4 threads)", to_string(acc), want[k], a, b);
+            BigDecimal T;
+            ck.expect("try_parse", try_parse(a, T) == ParseError::None ? to_string(T) : "<rejected>",
+                      ref_add(a, "0"), a, "0");
+
+            pairText += a + ' ' + b + '\n';
+            pairWant += want[k] + '\n';
+            sumText += a + '\n' + b + '\n';
+            total = ref_add(ref_add(total, a), b);
+        }
+        ck.expect("add_batch (short b)", add_batch(va, Span<BigDecimalView>(vb.data(), 1), batch) ? "ok" : "",
+                  "", "", "");
+        add_batch(va, vb, batch);
+        for (size_t k = 0; k < ta.size(); ++k) ck.expect("add_batch", string(batch[k]), want[k], ta[k], tb[k]);
+        // invalid tokens for the drivers
+        pairText += "1e5 " + ta[0] + '\n' + ta[1] + " -.5\n";
+        pairWant += "INVALID\nINVALID\n";
+        sumText += "+\n1.2.3\n";
+        invalid += 2;
+    }
+    par_add_threshold = saved;
+
+    // try_parse reports the error scan_double_literal does
+    for (string x : {"", "+", "-", "1e5", "1.", "-5.-5", "-.5", ".5", "1.2.3", "+-1", "12a", "000x", "1.5x",
+                     "123456789012.3.", "-0", "+000.000", "1234567890123456789", "-0.0000000001"}) {
+        BigDecimal T;
+        size_t dot;
+        ParseError want = scan_double_literal(x, dot), got = try_parse(x, T);
+        ck.expect("try_parse (error)", parse_error_text(got), parse_error_text(want), x, "");
+        if (want == ParseError::None) ck.expect("try_parse", to_string(T), ref_add(x, "0"), x, "0");
+    }
+
+    // the drivers, each against the reference or the serial run
+    string pairs = scratch_file(pairText), terms = scratch_file(sumText);
+    PairOptions sumOnly, human, fixed, binary;
+    sumOnly.fmt = OutputFormat::SumOnly;
+    fixed.fmt = OutputFormat::SumOnly;
+    fixed.fixedBatch = fixed_batch_for(20, 4);
+    binary.fmt = OutputFormat::Binary;
+    ck.expect("run_pairs", pair_run(pairs, sumOnly, 0), pairWant, "pair file", "");
+    ck.expect("run_pairs_parallel", pair_run(pairs, sumOnly, 1), pairWant, "pair file", "");
+    ck.expect("run_pairs_pipelined", pair_run(pairs, sumOnly, 2), pairWant, "pair file", "");
+    ck.expect("run_pairs --scale 20.4", pair_run(pairs, fixed, 0), pairWant, "pair file", "");
+    ck.expect("run_pairs --format binary", decode_binary(pair_run(pairs, binary, 0)), pairWant, "pair file", "");
+    ck.expect("run_pairs_parallel --format binary", decode_binary(pair_run(pairs, binary, 1)), pairWant,
+              "pair file", "");
+    PairOptions split = sumOnly;  // every sum too wide for 128 bits on add_into's split chains
+    split.threads = 4;
+    par_add_threshold = 0;
+    ck.expect("run_pairs (split adds)", pair_run(pairs, split, 0), pairWant, "pair file", "");
+    par_add_threshold = saved;
+    string serial = pair_run(pairs, human, 0);
+    ck.expect("run_pairs_parallel (human)", pair_run(pairs, human, 1), serial, "pair file", "");
+    ck.expect("run_pairs_pipelined (human)", pair_run(pairs, human, 2), serial, "pair file", "");
+
+    string totalWant = "Total: " + total + "\nInvalid tokens: " + std::to_string(invalid) + "\n";
+    auto sum_run = [&](int mode) {
+        return capture([&](OutputSink& sink) {
+            InputReader in;
+            if (!in.open(terms)) return;
+            BigDecimalAccumulator acc;
+            unsigned long long bad = 0;
+            if (mode == 0) run_sum(in, acc, bad);
+            else if (mode == 1) run_sum_parallel(in.mapped(), 3, acc, bad);
+            else run_sum_pipelined(in, acc, bad);
+            print_total(sink, acc.finish(), bad);
+        });
+    };
+    ck.expect("run_sum", sum_run(0), totalWant, "sum file", "");
+    ck.expect("run_sum_parallel", sum_run(1), totalWant, "sum file", "");
+    ck.expect("run_sum_pipelined", sum_run(2), totalWant, "sum file", "");
+    std::remove(pairs.c_str());
+    std::remove(terms.c_str());
+}
+
+// Each literal rounded in every mode to a few precisions
+static void check_round(Checker& ck, std::mt19937& rng) {
+    const RoundingMode modes[] = {RoundingMode::HalfEven, RoundingMode::HalfUp, RoundingMode::Truncate};
+    const char* names[] = {"round_to (half-even)", "round_to (half-up)", "round_to (truncate)"};
+    std::vector<string> xs = {"0.5", "1.5", "2.5", "-2.5", "0.05", "-0.949", "9.9999", "99.95", "0.000000000999999999"};
+    for (int k = 0; k < 3000; ++k) xs.push_back(fuzz_literal(rng, 600));
+    for (const string& x : xs) {
+        BigDecimal X = parse_normalize(x);
+        for (int m = 0; m < 3; ++m) {
+            size_t p = rng() % 4 == 0 ? rng() % 30 : rng() % 12;
+            BigDecimal r = X;
+            round_to(r, p, modes[m]);
+            ck.expect(names[m], to_string(r), ref_round(x, p, modes[m]), x, std::to_string(p));
+        }
+    }
+}
+
+// mul with its thresholds forced onto each algorithm, then the drivers
+static void check_mul(Checker& ck, std::mt19937& rng) {
+    std::vector<string> ta, tb, want;
+    string pairText, pairWant;
+    for (int k = 0; k < 400; ++k) {
+        ta.push_back(fuzz_literal(rng, 2400));
+        tb.push_back(rng() % 8 ? fuzz_literal(rng, 2400) : ta.back());
+        want.push_back(ref_mul(ta.back(), tb.back()));
+        pairText += ta.back() + ' ' + tb.back() + '\n';
+        pairWant += want.back() + '\n';
+    }
+    pairText += "1. 2\n3 0x1\n";
+    pairWant += "INVALID\nINVALID\n";
+
+    constexpr size_t NEVER = SIZE_MAX;
+    const struct {
+        const char* name;
+        MulThresholds t;
+    } forced[] = {
+        {"mul (schoolbook)", {NEVER, NEVER, NEVER}},
+        {"mul (Karatsuba)", {2, NEVER, NEVER}},
+        {"mul (Toom-3)", {2, 3, NEVER}},
+        {"mul (NTT)", {1, NEVER, 1}},
+        {"mul (mixed)", {4, 12, 48}},
+        {"mul", MulThresholds{}},
+    };
+    const MulThresholds saved = mul_thresholds;
+    for (const auto& f : forced) {
+        mul_thresholds = f.t;
+        for (size_t k = 0; k < ta.size(); ++k)
+            ck.expect(f.name, to_string(mul(parse_normalize(ta[k]), parse_normalize(tb[k]))), want[k], ta[k], tb[k]);
+    }
+    mul_thresholds = saved;
+
+    // --op mul, with the result cache cold, warm, reloaded and damaged
+    string pairs = scratch_file(pairText);
+    PairOptions opt, binary;
+    opt.fmt = OutputFormat::SumOnly;
+    opt.op = binary.op = PairOp::Mul;
+    binary.fmt = OutputFormat::Binary;
+    ck.expect("run_pairs --op mul", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+    ck.expect("run_pairs_parallel --op mul", pair_run(pairs, opt, 1), pairWant, "pair file", "");
+    ck.expect("run_pairs --op mul --format binary", decode_binary(pair_run(pairs, binary, 0)), pairWant,
+              "pair file", "");
+
+    {
+        ResultCache memory;
+        opt.cache = &memory;
+        if (!memory.open("")) ck.expect("cache (memory)", "cannot map", "", "", "");
+        ck.expect("run_pairs --op mul --cache (cold)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+        ck.expect("run_pairs --op mul --cache (warm)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+        ck.expect("run_pairs_parallel --op mul --cache", pair_run(pairs, opt, 1), pairWant, "pair file", "");
+    }
+    string path = scratch_file("");
+    for (const char* pass : {"run_pairs --op mul --cache-file (cold)", "run_pairs --op mul --cache-file (warm)"}) {
+        ResultCache file;
+        opt.cache = &file;
+        if (!file.open(path)) ck.expect("cache (file)", "cannot map", "", path, "");
+        ck.expect(pass, pair_run(pairs, opt, 0), pairWant, "pair file", "");
+        ResultCache second;
+        ck.expect("cache (file held)", second.open(path) ? "opened" : errno == EWOULDBLOCK ? "in use" : "failed",
+                  "in use", path, "");
+    }
+    ck.expect("cache (slots written)", corrupt_cache(path) ? "some" : "none", "some", path, "");
+    {
+        ResultCache file;
+        opt.cache = &file;
+        if (!file.open(path)) ck.expect("cache (file)", "cannot map", "", path, "");
+        ck.expect("run_pairs --op mul --cache-file (damaged)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+        ck.expect("run_pairs --op mul --cache-file (repaired)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+    }
+    std::remove(path.c_str());
+    std::remove(pairs.c_str());
+}
+
+// div in each rounding mode to assorted precisions, Knuth D and Newton
+static void check_div(Checker& ck, std::mt19937& rng) {
+    const RoundingMode modes[] = {RoundingMode::HalfEven, RoundingMode::HalfUp, RoundingMode::Truncate};
+    struct Case {
+        string a, b;
+        size_t p;
+        RoundingMode mode;
+        string want;
+    };
+    // ties, and remainders just past them that only the sticky digit sees
+    std::vector<Case> cases = {
+        {"1", "8", 2, RoundingMode::HalfEven, ""},
+        {"-3", "8", 2, RoundingMode::HalfUp, ""},
+        {"0.5000000000000000000000000001", "1", 0, RoundingMode::HalfEven, ""},
+        {"-2.5000000000000000000001", "1", 0, RoundingMode::HalfEven, ""},
+        {"0.1250000000000000000000000000000001", "-1", 2, RoundingMode::HalfEven, ""},
+        {"7.50000000000000000003", "3", 0, RoundingMode::HalfEven, ""},
+    };
+    for (Case& c : cases) c.want = ref_div(c.a, c.b, c.p, c.mode);
+    for (int k = 0; k < 600; ++k) {
+        Case c{fuzz_literal(rng, 300), fuzz_literal(rng, 300), 0, modes[rng() % 3], ""};
+        if (is_zero(c.b)) c.b = "-0.7";
+        unsigned r = rng() % 8;
+        c.p = r == 0 ? SIZE_MAX : r == 1 ? rng() % 200 : rng() % 30;
+        c.want = ref_div(c.a, c.b, c.p, c.mode);
+        cases.push_back(c);
+    }
+
+    const size_t saved = div_newton_threshold;
+    for (size_t threshold : {SIZE_MAX, size_t(2)}) {
+        div_newton_threshold = threshold;
+        const char* what = threshold == SIZE_MAX ? "div (Knuth D)" : "div (Newton)";
+        for (const Case& c : cases)
+            ck.expect(what, to_string(div(parse_normalize(c.a), parse_normalize(c.b), c.p, c.mode)), c.want, c.a,
+                      c.b + " @" + std::to_string(c.p));
+    }
+    div_newton_threshold = saved;
+
+    // --op div at one precision, division by zero included, with and without the cache
+    PairOptions opt;
+    opt.fmt = OutputFormat::SumOnly;
+    opt.op = PairOp::Div;
+    opt.ctx.precision = 25;
+    opt.ctx.rounding = RoundingMode::HalfUp;
+    string pairText, pairWant;
+    for (const Case& c : cases) {
+        pairText += c.a + ' ' + c.b + '\n';
+        pairWant += ref_div(c.a, c.b, opt.ctx.precision, opt.ctx.rounding) + '\n';
+    }
+    pairText += "1 0\n-2.5 -0.000\n";
+    pairWant += "INVALID\nINVALID\n";
+    string pairs = scratch_file(pairText);
+    ck.expect("run_pairs --op div", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+    ck.expect("run_pairs_pipelined --op div", pair_run(pairs, opt, 2), pairWant, "pair file", "");
+    ResultCache memory;
+    if (memory.open("")) opt.cache = &memory;
+    ck.expect("run_pairs --op div --cache (cold)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+    ck.expect("run_pairs --op div --cache (warm)", pair_run(pairs, opt, 0), pairWant, "pair file", "");
+    std::remove(pairs.c_str());
+}
+
+int main() {
+    std::mt19937 rng(2024);
+    Checker ck;
+    check_add(ck, rng);
+    check_round(ck, rng);
+    check_mul(ck, rng);
+    check_div(ck, rng);
+    std::printf("check: %zu comparisons, %zu mismatches\n", ck.cases, ck.bad);
+    return ck.bad ? 1 : 0;
+}
@@ -0,0 +1,685 @@
+// calc's driver, declared in driver.h.
+#include "driver.h"
+
+#include <condition_variable>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+
+namespace calc {
+
+/* -------------------- Run statistics -------------------- */
+
+static std::mutex stats_mutex;
+static DriverStats stats_total;  // blocks of threads that have exited
+
+struct ThreadStats : DriverStats {
+    ~ThreadStats() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats_total.merge(*this);
+    }
+};
+
+DriverStats& driver_stats_local() {
+    static thread_local ThreadStats s;
+    return s;
+}
+
+DriverStats driver_stats_snapshot() {
+    DriverStats t;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        t = stats_total;
+    }
+    t.merge(driver_stats_local());
+    return t;
+}
+
+/* -------------------- I/O & Driver -------------------- */
+
+static inline void put_le32(string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(char((v >> (8 * i)) & 0xff));
+}
+
+static void put_binary_record(string& out, const BigDecimal* sum) {
+    uint32_t len = sum ? uint32_t(1 + 1 + 4 + 4 + 4 * sum->limbs.size()) : 1;
+    put_le32(out, len);
+    if (!sum) { out.push_back('\1'); return; }
+    out.push_back('\0');
+    out.push_back(char(int8_t(sum->sign)));
+    put_le32(out, uint32_t(-int32_t(sum->frac)));
+    put_le32(out, uint32_t(sum->limbs.size()));
+    for (uint32_t l : sum->limbs) put_le32(out, l);
+}
+
+// Result cache key of a case: op and context, then both operands
+static void cache_key(string& key, const PairOptions& opt, BigDecimalView a, BigDecimalView b) {
+    key.clear();
+    uint64_t precision = opt.ctx.precision;
+    key.push_back(char(opt.op));
+    key.push_back(char(opt.ctx.rounding));
+    key.append(reinterpret_cast<const char*>(&precision), sizeof precision);
+    to_string(a, key);
+    key.push_back(' ');
+    to_string(b, key);
+}
+
+// Look the case up in opt.cache, keeping the key for an insert on a miss.
+// A hit leaves the result text in c.sumText.
+static bool cache_lookup(const PairOptions& opt, CaseBuffers& c) {
+    cache_key(c.key, opt, c.va, c.vb);
+    if (!opt.cache->find(c.key, c.sumText)) {
+        STAT_ADD(cacheMisses, 1);
+        return false;
+    }
+    STAT_ADD(cacheHits, 1);
+    return true;
+}
+
+static void put_case(string& out, const PairOptions& opt, long long caseNo, std::string_view a,
+                     std::string_view b, CaseBuffers& c, ParseError errA, ParseError errB, bool divByZero);
+
+// Compute and format one case whose operands have been scanned (errA/dotA
+// and errB/dotB as scan_double_literal reports them).
+static void run_scanned(string& out, const PairOptions& opt, long long caseNo, std::string_view a,
+                        std::string_view b, ParseError errA, size_t dotA, ParseError errB, size_t dotB,
+                        CaseBuffers& c) {
+    STAT_LAP(lap);
+    bool okA = errA == ParseError::None, okB = errB == ParseError::None;
+    c.repr = CaseRepr::Big;
+    // only cases for limbs are worth a lookup; the other paths beat the hash
+    bool cacheable = opt.cache && opt.fmt != OutputFormat::Binary;
+    bool cacheMiss = false;
+    if (okA && okB) {
+        // stay in 128 bits while the operands (and below, the result) fit;
+        // a wider exact sum that is only printed can stay on the digit text,
+        // unless it is big enough for add_into to split over opt.threads
+        BigDecimalView va = make_view(a, dotA), vb = make_view(b, dotB);
+        c.va = va;
+        c.vb = vb;
+        size_t digits = std::max(va.intPart.size() + va.fracPart.size(), vb.intPart.size() + vb.fracPart.size());
+        bool split = opt.threads > 1 && digits / LIMB_DIGITS >= par_add_threshold;
+        if (opt.op != PairOp::Div && assign(c.a, va) && assign(c.b, vb)) {
+            c.repr = CaseRepr::Small;
+        } else if (opt.op == PairOp::Add && opt.fmt != OutputFormat::Binary && !split &&
+                   std::max(va.fracPart.size(), vb.fracPart.size()) <= opt.ctx.precision) {
+            c.repr = CaseRepr::Text;
+        } else if (cacheable && cache_lookup(opt, c)) {
+            c.repr = CaseRepr::Formatted;
+        } else {
+            assign(c.A, va);
+            assign(c.B, vb);
+            cacheMiss = cacheable;
+        }
+    }
+    STAT_MARK(lap, parseNs);
+    bool divByZero = okA && okB && opt.op == PairOp::Div && c.vb.isZero();
+    bool ok = okA && okB && !divByZero;
+    if (ok && c.repr == CaseRepr::Small &&
+        !((opt.op == PairOp::Add ? add_small(c.a, c.b, c.s) : mul_small(c.a, c.b, c.s)) &&
+          c.s.scale <= opt.ctx.precision)) {
+        if (cacheable && cache_lookup(opt, c)) {
+            c.repr = CaseRepr::Formatted;
+        } else {
+            c.repr = CaseRepr::Big;
+            assign(c.A, c.a);  // promote
+            assign(c.B, c.b);
+            cacheMiss = cacheable;
+        }
+    }
+    if (ok && c.repr == CaseRepr::Text) c.vs = add_views(c.va, c.vb, c.sumText, c.padText);
+    if (ok && c.repr == CaseRepr::Big) {
+        switch (opt.op) {
+        case PairOp::Add: copy_widened(c.S, c.A, c.B.frac); add_into(c.S, c.B, opt.threads); break;
+        case PairOp::Mul: c.S = mul(c.A, c.B); break;
+        case PairOp::Div: c.S = div(c.A, c.B, opt.ctx.precision, opt.ctx.rounding); break;
+        }
+        round_to(c.S, opt.ctx.precision, opt.ctx.rounding);
+        if (cacheMiss) {
+            c.sumText.clear();
+            to_string(c.S, c.sumText);
+            opt.cache->insert(c.key, c.sumText);
+            c.repr = CaseRepr::Formatted;
+        }
+    }
+    STAT_MARK(lap, computeNs);
+    put_case(out, opt, caseNo, a, b, c, errA, errB, divByZero);
+}
+
+// Append the text of a computed case: the result is in c as c.repr says.
+static void put_case(string& out, const PairOptions& opt, long long caseNo, std::string_view a,
+                     std::string_view b, CaseBuffers& c, ParseError errA, ParseError errB, bool divByZero) {
+    STAT_SCOPE(formatTime, formatNs);
+    bool ok = errA == ParseError::None && errB == ParseError::None && !divByZero;
+    // operands are echoed straight from the input (their views); only the
+    // result is rendered from whichever representation holds it
+    auto put = [&] {
+        switch (c.repr) {
+        case CaseRepr::Big: to_string(c.S, out); break;
+        case CaseRepr::Small: to_string(c.s, out); break;
+        case CaseRepr::Text: to_string(c.vs, out); break;
+        case CaseRepr::Formatted: out += c.sumText; break;
+        }
+    };
+    const char* opText = opt.op == PairOp::Add ? " + " : opt.op == PairOp::Mul ? " * " : " / ";
+
+    switch (opt.fmt) {
+    case OutputFormat::SumOnly:
+        if (ok) put();
+        else out += "INVALID";
+        out += "\n";
+        return;
+    case OutputFormat::Tsv:
+        append_uint(out, static_cast<unsigned long long>(caseNo));
+        out += ok ? "\tok\t" : "\tinvalid\t";
+        if (ok) put();
+        else out += divByZero ? "division by zero" : parse_error_text(errA != ParseError::None ? errA : errB);
+        out += "\n";
+        return;
+    case OutputFormat::Binary:
+        if (c.repr == CaseRepr::Small) assign(c.S, c.s);
+        put_binary_record(out, ok ? &c.S : nullptr);
+        return;
+    case OutputFormat::Human:
+        break;
+    }
+
+    out += "Case ";
+    append_uint(out, static_cast<unsigned long long>(caseNo));
+    out += ": ";
+    out += a;
+    out += opText;
+    out += b;
+    out += "\n";
+    if (errA != ParseError::None || errB != ParseError::None) {
+        bool badA = errA != ParseError::None;
+        out += "  -> INVALID: '";
+        out += badA ? a : b;
+        out += "' is not a valid double literal (";
+        out += parse_error_text(badA ? errA : errB);
+        out += ").\n\n";
+    } else if (divByZero) {
+        out += "  -> INVALID: division by zero.\n\n";
+    } else {
+        out += "  -> ";
+        to_string(c.va, out);
+        out += opText;
+        to_string(c.vb, out);
+        out += " = ";
+        put();
+        out += "\n\n";
+    }
+}
+
+void run_case(string& out, const PairOptions& opt, long long caseNo,
+                     std::string_view a, std::string_view b, CaseBuffers& c) {
+    STAT_LAP(lap);
+    size_t dotA, dotB;
+    ParseError errA = scan_double_literal(a, dotA);
+    ParseError errB = scan_double_literal(b, dotB);
+    STAT_MARK(lap, parseNs);
+    run_scanned(out, opt, caseNo, a, b, errA, dotA, errB, dotB, c);
+}
+
+// --scale: n consecutive cases (operands tok[2i], tok[2i + 1]) through the
+// FixedDecimal<I, F> batch adder; cases outside the schema take run_scanned.
+template <unsigned I, unsigned F>
+static void run_fixed_batch(string& out, const PairOptions& opt, long long caseNo,
+                            const std::string_view* tok, size_t n, CaseBuffers& c) {
+    using FD = FixedDecimal<I, F>;
+    using Rep = typename FD::Rep;
+    Rep a[FIXED_BATCH], b[FIXED_BATCH], r[FIXED_BATCH];
+    uint8_t ok[FIXED_BATCH];
+    ParseError err[2 * FIXED_BATCH];
+    size_t dot[2 * FIXED_BATCH];
+    BigDecimalView view[2 * FIXED_BATCH];
+
+    STAT_LAP(lap);
+    for (size_t i = 0; i < n; ++i) {
+        FD x, y;
+        err[2 * i] = scan_double_literal(tok[2 * i], dot[2 * i]);
+        err[2 * i + 1] = scan_double_literal(tok[2 * i + 1], dot[2 * i + 1]);
+        ok[i] = err[2 * i] == ParseError::None && err[2 * i + 1] == ParseError::None;
+        if (ok[i]) {
+            view[2 * i] = make_view(tok[2 * i], dot[2 * i]);
+            view[2 * i + 1] = make_view(tok[2 * i + 1], dot[2 * i + 1]);
+            ok[i] = FD::load(view[2 * i], x) && FD::load(view[2 * i + 1], y);
+        }
+        a[i] = ok[i] ? x.v : 0;
+        b[i] = ok[i] ? y.v : 0;
+    }
+    std::fill(a + n, a + FIXED_BATCH, Rep(0));
+    std::fill(b + n, b + FIXED_BATCH, Rep(0));
+    STAT_MARK(lap, parseNs);
+    FD::add_batch(a, b, r);
+    STAT_MARK(lap, computeNs);
+
+    for (size_t i = 0; i < n; ++i) {
+        std::string_view ta = tok[2 * i], tb = tok[2 * i + 1];
+        if (!ok[i] || !FD::in_range(r[i])) {
+            run_scanned(out, opt, caseNo + 1 + static_cast<long long>(i), ta, tb, err[2 * i], dot[2 * i],
+                        err[2 * i + 1], dot[2 * i + 1], c);
+            continue;
+        }
+        FD sum;
+        sum.v = r[i];
+        c.sumText.resize(FD::N + 3);
+        c.sumText.resize(sum.format(&c.sumText[0]));
+        c.repr = CaseRepr::Formatted;
+        c.va = view[2 * i];
+        c.vb = view[2 * i + 1];
+        put_case(out, opt, caseNo + 1 + static_cast<long long>(i), ta, tb, c, ParseError::None,
+                 ParseError::None, false);
+    }
+}
+
+// The batch adder for --scale I.F: F picks the instantiation, I only
+// whether it needs 128 bits (a wider I than asked for is still exact).
+template <unsigned... F>
+static FixedBatchFn pick_fixed_batch(unsigned i, unsigned f, std::integer_sequence<unsigned, F...>) {
+    static const FixedBatchFn narrow[] = {run_fixed_batch<18 - F, F>...};
+    static const FixedBatchFn wide[] = {run_fixed_batch<37 - F, F>...};
+    return i + f <= 18 ? narrow[f] : wide[f];
+}
+
+FixedBatchFn fixed_batch_for(unsigned i, unsigned f) {
+    if (f > FIXED_MAX_FRAC || i + f > 37) return nullptr;
+    return pick_fixed_batch(i, f, std::make_integer_sequence<unsigned, FIXED_MAX_FRAC + 1>());
+}
+
+// Feeds cases to run_case, or with --scale in blocks to opt.fixedBatch.
+// The token views passed to add() must stay valid until flush().
+class CaseRunner {
+public:
+    CaseRunner(const PairOptions& opt, CaseBuffers& bufs) : opt_(opt), bufs_(bufs) {}
+
+    void add(string& out, long long caseNo, std::string_view a, std::string_view b) {
+        if (!opt_.fixedBatch) {
+            run_case(out, opt_, caseNo, a, b, bufs_);
+            return;
+        }
+        if (n_ == 0) first_ = caseNo - 1;
+        tok_[2 * n_] = a;
+        tok_[2 * n_ + 1] = b;
+        if (++n_ == FIXED_BATCH) flush(out);
+    }
+
+    void flush(string& out) {
+        if (n_) opt_.fixedBatch(out, opt_, first_, tok_, n_, bufs_);
+        n_ = 0;
+    }
+
+private:
+    const PairOptions& opt_;
+    CaseBuffers& bufs_;
+    std::string_view tok_[2 * FIXED_BATCH];
+    size_t n_ = 0;
+    long long first_ = 0;  // case number before the block's first
+};
+
+void run_pairs(InputReader& in, OutputSink& sink, const PairOptions& opt) {
+    std::string_view tok[2];
+    CaseBuffers bufs;
+    CaseRunner runner(opt, bufs);
+    // streamed tokens only live until the next fetch, so only a mapped file is batched
+    bool batch = opt.fixedBatch && !in.mapped().empty();
+    long long caseNo = 0;
+    while (in.next(tok, 2)) {
+        if (batch) runner.add(sink.buffer(), ++caseNo, tok[0], tok[1]);
+        else run_case(sink.buffer(), opt, ++caseNo, tok[0], tok[1], bufs);
+        sink.commit();
+    }
+    runner.flush(sink.buffer());
+    sink.commit();
+}
+
+/* -------------------- Batch mode (-j N) -------------------- */
+
+// Next token in data starting at pos, or false if none starts before end.
+static inline bool next_token(std::string_view data, size_t& pos, size_t end, std::string_view& tok) {
+    while (pos < end && is_space(data[pos])) ++pos;
+    if (pos >= end) return false;
+    size_t start = pos;
+    while (pos < data.size() && !is_space(data[pos])) ++pos;
+    tok = data.substr(start, pos - start);
+    return true;
+}
+
+// Per-worker bump allocator for the limbs of one chunk's cases. Nothing is
+// freed until reset(), which rewinds to the start of the worker's buffer, so
+// long operands cost no trips to the (shared) global heap.
+class ChunkArena {
+public:
+    std::pmr::memory_resource* resource() { return &pool_; }
+    void reset() { pool_.release(); }
+
+private:
+    static constexpr size_t BYTES = size_t(256) << 10;  // larger chunks fall back upstream
+    std::unique_ptr<char[]> buf_{new char[BYTES]};
+    std::pmr::monotonic_buffer_resource pool_{buf_.get(), BYTES};
+};
+
+// Chunk boundaries: about `target` bytes each, every one just past a '\n'.
+static std::vector<size_t> split_lines(std::string_view data, size_t target) {
+    std::vector<size_t> bounds{0};
+    while (bounds.back() < data.size()) {
+        size_t p = bounds.back() + target;
+        if (p >= data.size()) { bounds.push_back(data.size()); break; }
+        size_t nl = data.find('\n', p);
+        bounds.push_back(nl == std::string_view::npos ? data.size() : nl + 1);
+    }
+    return bounds;
+}
+
+// Bytes per chunk, the scheduling weight of each
+static std::vector<size_t> chunk_bytes(const std::vector<size_t>& bounds) {
+    std::vector<size_t> w(bounds.size() - 1);
+    for (size_t k = 0; k < w.size(); ++k) w[k] = bounds[k + 1] - bounds[k];
+    return w;
+}
+
+// Chunk size giving each worker several chunks to balance over
+static size_t chunk_target(size_t bytes, unsigned threads) {
+    return std::clamp<size_t>(bytes / (size_t(threads) * 16), size_t(1) << 16, size_t(1) << 24);
+}
+
+void run_pairs_parallel(std::string_view data, unsigned threads, OutputSink& sink,
+                        const PairOptions& opt) {
+    std::vector<size_t> bounds = split_lines(data, chunk_target(data.size(), threads));
+    std::vector<size_t> weight = chunk_bytes(bounds);
+    size_t chunks = bounds.size() - 1;
+
+    // pass 1: tokens per chunk, then how many precede each chunk
+    std::vector<size_t> before(chunks + 1, 0);
+    parallel_for(chunks, threads, [&](size_t k) {
+        size_t pos = bounds[k], n = 0;
+        std::string_view tok;
+        while (next_token(data, pos, bounds[k + 1], tok)) ++n;
+        before[k + 1] = n;
+    }, &weight);
+    for (size_t k = 0; k < chunks; ++k) before[k + 1] += before[k];
+
+    // pass 2: cases per chunk, written back in order as chunks complete.
+    // A huge addition may split over the threads no worker is using, so
+    // the run stays near `threads` threads in all
+    PairOptions inner = opt;
+    inner.threads = std::max(1u, threads / unsigned(std::clamp<size_t>(chunks, 1, threads)));
+    // A chunk starts only within `ahead` chunks of the writer, so the text
+    // finished behind one slow chunk stays bounded. Shares are walked in
+    // index order and thieves take from the far end, so the chunk the
+    // writer waits for is always claimed by a worker that is not waiting.
+    const size_t ahead = 2 * size_t(threads);
+    std::vector<string> outs(chunks);
+    std::vector<char> done(chunks, 0);
+    size_t written = 0;
+    std::mutex m;
+    std::condition_variable cv, room;
+
+    std::thread writer([&] {
+        for (size_t k = 0; k < chunks; ++k) {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [&] { return done[k] != 0; });
+            lock.unlock();
+            sink.write(outs[k]);
+            string().swap(outs[k]);
+            lock.lock();
+            written = k + 1;
+            lock.unlock();
+            room.notify_all();
+        }
+    });
+
+    parallel_for(chunks, threads, [&](size_t k) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            room.wait(lock, [&] { return k < written + ahead; });
+        }
+        static thread_local ChunkArena arena;
+        {
+            CaseBuffers bufs(arena.resource());
+            CaseRunner runner(inner, bufs);
+            string& out = outs[k];
+            size_t pos = bounds[k], end = bounds[k + 1];
+            long long caseNo = static_cast<long long>((before[k] + 1) / 2);
+            std::string_view a, b;
+            if (before[k] % 2) next_token(data, pos, end, a);  // completes the previous pair
+            while (next_token(data, pos, end, a) && next_token(data, pos, data.size(), b))
+                runner.add(out, ++caseNo, a, b);
+            runner.flush(out);
+        }
+        arena.reset();  // the chunk's buffers are gone; its text lives in outs[k]
+        {
+            std::lock_guard<std::mutex> lock(m);
+            done[k] = 1;
+        }
+        cv.notify_all();
+    }, &weight);
+    writer.join();
+}
+
+void print_total(OutputSink& sink, const BigDecimal& total, unsigned long long invalid) {
+    string& out = sink.buffer();
+    out += "Total: ";
+    to_string(total, out);
+    out += "\nInvalid tokens: ";
+    append_uint(out, invalid);
+    out += "\n";
+    sink.commit();
+}
+
+void run_sum(InputReader& in, BigDecimalAccumulator& total, unsigned long long& invalid) {
+    BigDecimal term;
+    std::string_view tok;
+    while (in.next(&tok, 1)) {
+        STAT_LAP(lap);
+        bool ok = try_parse(tok, term) == ParseError::None;
+        STAT_MARK(lap, parseNs);
+        if (ok) total.add(term);
+        else ++invalid;
+        STAT_MARK(lap, computeNs);
+    }
+}
+
+// Per-chunk partial of a parallel sum; signed lanes need no compare per term.
+struct SumPartial {
+    BigDecimalAccumulator acc;
+    unsigned long long invalid = 0;
+};
+
+void run_sum_parallel(std::string_view data, unsigned threads,
+                      BigDecimalAccumulator& total, unsigned long long& invalid) {
+    std::vector<size_t> bounds = split_lines(data, chunk_target(data.size(), threads));
+    std::vector<size_t> weight = chunk_bytes(bounds);
+    size_t chunks = bounds.size() - 1;
+
+    std::vector<SumPartial> parts(chunks);
+    parallel_for(chunks, threads, [&](size_t k) {
+        SumPartial& p = parts[k];
+        BigDecimal term;
+        size_t pos = bounds[k];
+        std::string_view tok;
+        while (next_token(data, pos, bounds[k + 1], tok)) {
+            STAT_LAP(lap);
+            bool ok = try_parse(tok, term) == ParseError::None;
+            STAT_MARK(lap, parseNs);
+            if (ok) p.acc.add(term);
+            else ++p.invalid;
+            STAT_MARK(lap, computeNs);
+        }
+    }, &weight);
+
+    // pairwise tree: level by level, partial i absorbs partial i + step
+    for (size_t step = 1; step < chunks; step *= 2) {
+        size_t pairs = (chunks + 2 * step - 1) / (2 * step);
+        parallel_for(pairs, threads, [&](size_t j) {
+            size_t i = j * 2 * step;
+            if (i + step >= chunks) return;
+            parts[i].acc.merge(parts[i + step].acc);
+            parts[i].invalid += parts[i + step].invalid;
+            parts[i + step] = SumPartial{};
+        });
+    }
+
+    if (chunks > 0) {
+        total.merge(parts[0].acc);
+        invalid += parts[0].invalid;
+    }
+}
+
+/* -------------------- Pipelined mode (--pipeline) -------------------- */
+
+// Lock-free bounded queue for exactly one producer and one consumer thread.
+// Both sides yield while the ring is full or empty.
+template <class T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    void push(T v) {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        while (t - head_.load(std::memory_order_acquire) == N) std::this_thread::yield();
+        slots_[t % N] = std::move(v);
+        tail_.store(t + 1, std::memory_order_release);
+    }
+
+    // Next item, or false once the producer has closed and the ring is drained.
+    bool pop(T& v) {
+        size_t h = head_.load(std::memory_order_relaxed);
+        while (h == tail_.load(std::memory_order_acquire)) {
+            if (closed_.load(std::memory_order_acquire) && h == tail_.load(std::memory_order_acquire))
+                return false;
+            std::this_thread::yield();
+        }
+        v = std::move(slots_[h % N]);
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: no more pushes follow.
+    void close() { closed_.store(true, std::memory_order_release); }
+
+private:
+    T slots_[N];
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to pop
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to push
+    std::atomic<bool> closed_{false};
+};
+
+// Input handed from the reader to the compute stage, ending at a token
+// boundary: bytes read from a stream, or a slice of the mapping.
+struct PipeChunk {
+    string buf;
+    std::string_view slice;
+
+    std::string_view text() const { return buf.empty() ? slice : std::string_view(buf); }
+};
+
+static constexpr size_t PIPE_CHUNK = size_t(1) << 20;
+static constexpr size_t PIPE_DEPTH = 4;  // chunks per ring
+
+using PipeInput = SpscRing<PipeChunk, PIPE_DEPTH>;
+
+// Reader stage: cut the input into chunks of about PIPE_CHUNK bytes that end
+// just past whitespace (or at the end of input), so no token is split.
+static void pipe_read(InputReader& in, PipeInput& ring) {
+    std::string_view whole = in.mapped();
+    if (!whole.empty()) {
+        for (size_t pos = 0; pos < whole.size();) {
+            size_t end = std::min(pos + PIPE_CHUNK, whole.size());
+            while (end < whole.size() && !is_space(whole[end - 1])) ++end;
+            // fault the pages in here rather than in the compute stage
+            const volatile char* page = whole.data();
+            for (size_t p = pos; p < end; p += 4096) (void)page[p];
+            PipeChunk c;
+            c.slice = whole.substr(pos, end - pos);
+            ring.push(std::move(c));
+            pos = end;
+        }
+        ring.close();
+        return;
+    }
+
+    string carry;  // the partial token at the end of the previous block
+    bool eof = false;
+    while (!eof) {
+        PipeChunk c;
+        c.buf.swap(carry);
+        size_t cut = string::npos;
+        while (!eof && (c.buf.size() < PIPE_CHUNK || cut == string::npos)) {
+            size_t old = c.buf.size();
+            c.buf.resize(old + PIPE_CHUNK);
+            size_t n = in.read_raw(&c.buf[old], PIPE_CHUNK);
+            c.buf.resize(old + n);
+            eof = n == 0;
+            for (size_t i = c.buf.size(); i-- > old;)
+                if (is_space(c.buf[i])) { cut = i + 1; break; }
+        }
+        if (eof) cut = c.buf.size();
+        carry.assign(c.buf, cut, string::npos);
+        c.buf.resize(cut);
+        if (!c.buf.empty()) ring.push(std::move(c));
+    }
+    ring.close();
+}
+
+void run_pairs_pipelined(InputReader& in, OutputSink& sink, const PairOptions& opt) {
+    PipeInput input;
+    SpscRing<string, PIPE_DEPTH> output;
+    std::thread reader([&] { pipe_read(in, input); });
+    std::thread writer([&] {
+        string s;
+        while (output.pop(s)) sink.write(s);
+    });
+
+    CaseBuffers bufs;
+    CaseRunner runner(opt, bufs);  // flushed before the chunk or `first` changes
+    long long caseNo = 0;
+    string first;  // a pair's first operand left at the end of the previous chunk
+    bool haveFirst = false;
+    PipeChunk c;
+    while (input.pop(c)) {
+        string out;
+        std::string_view t = c.text(), a, b;
+        size_t pos = 0;
+        if (haveFirst && next_token(t, pos, t.size(), b)) {
+            runner.add(out, ++caseNo, first, b);
+            haveFirst = false;
+        }
+        while (!haveFirst && next_token(t, pos, t.size(), a)) {
+            if (next_token(t, pos, t.size(), b)) {
+                runner.add(out, ++caseNo, a, b);
+            } else {
+                runner.flush(out);
+                first.assign(a.data(), a.size());
+                haveFirst = true;
+            }
+        }
+        runner.flush(out);
+        if (!out.empty()) output.push(std::move(out));
+    }
+    output.close();
+    reader.join();
+    writer.join();
+}
+
+void run_sum_pipelined(InputReader& in, BigDecimalAccumulator& total, unsigned long long& invalid) {
+    PipeInput input;
+    std::thread reader([&] { pipe_read(in, input); });
+    BigDecimal term;
+    PipeChunk c;
+    while (input.pop(c)) {
+        std::string_view t = c.text(), tok;
+        size_t pos = 0;
+        while (next_token(t, pos, t.size(), tok)) {
+            STAT_LAP(lap);
+            bool ok = try_parse(tok, term) == ParseError::None;
+            STAT_MARK(lap, parseNs);
+            if (ok) total.add(term);
+            else ++invalid;
+            STAT_MARK(lap, computeNs);
+        }
+    }
+    reader.join();
+}
+
+}  // namespace calc
@@ -0,0 +1,573 @@
+// calc's driver: input, output, the result cache and the pair and sum
+// runners (serial, -j, --pipeline), built on libbigdecimal. Lab10.cpp
+// holds main(); bench.cpp links the same objects.
+#ifndef CALC_DRIVER_H
+#define CALC_DRIVER_H
+
+#include "bigdecimal.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace calc {
+
+using namespace bigdecimal;
+using std::string;
+
+/* -------------------- Run statistics (-DCALC_STATS) -------------------- */
+/*
+   The driver's half of --stats: bytes in and out, time per stage and result
+   cache lookups (the core counts literals in bigdecimal::Stats). Blocks are
+   per thread and folded into the total as threads exit, as the core's are.
+   The STAT_* hooks are compiled in only with -DCALC_STATS (make
+   calc-stats), so the default build pays nothing: they expand to no-ops.
+*/
+
+struct DriverStats {
+    uint64_t bytesRead = 0, bytesWritten = 0;
+    uint64_t parseNs = 0, computeNs = 0, formatNs = 0, writeNs = 0;
+    uint64_t cacheHits = 0, cacheMisses = 0;
+
+    void merge(const DriverStats& o) {
+        bytesRead += o.bytesRead;
+        bytesWritten += o.bytesWritten;
+        parseNs += o.parseNs;
+        computeNs += o.computeNs;
+        formatNs += o.formatNs;
+        writeNs += o.writeNs;
+        cacheHits += o.cacheHits;
+        cacheMisses += o.cacheMisses;
+    }
+};
+
+// The calling thread's block.
+DriverStats& driver_stats_local();
+
+// The blocks of threads that have exited plus the calling thread's.
+DriverStats driver_stats_snapshot();
+
+#ifdef CALC_STATS
+// Adds the time since the previous mark (or construction) to a DriverStats field.
+class StatLap {
+public:
+    void mark(uint64_t DriverStats::*field) {
+        auto now = std::chrono::steady_clock::now();
+        driver_stats_local().*field += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - t_).count());
+        t_ = now;
+    }
+
+private:
+    std::chrono::steady_clock::time_point t_ = std::chrono::steady_clock::now();
+};
+
+// Adds the time until the end of its scope to a DriverStats field.
+class StatScope {
+public:
+    explicit StatScope(uint64_t DriverStats::*field) : field_(field) {}
+    ~StatScope() { lap_.mark(field_); }
+
+private:
+    uint64_t DriverStats::*field_;
+    StatLap lap_;
+};
+
+#define STAT_ADD(field, n) (driver_stats_local().field += (n))
+#define STAT_LAP(lap) StatLap lap
+#define STAT_MARK(lap, field) lap.mark(&DriverStats::field)
+#define STAT_SCOPE(name, field) StatScope name(&DriverStats::field)
+#else
+#define STAT_ADD(field, n) ((void)0)
+#define STAT_LAP(lap) ((void)0)
+#define STAT_MARK(lap, field) ((void)0)
+#define STAT_SCOPE(name, field) ((void)0)
+#endif
+
+/* -------------------- Input reader -------------------- */
+/*
+   Whitespace-separated tokens handed out as views, with no per-token copy.
+   Regular files are mapped whole; pipes and other streams fall back to
+   read() into a large buffer that slides forward as tokens are released.
+   Tokens are fetched in small groups (e.g. both operands of a pair) that
+   stay valid together until the next fetch.
+*/
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+class InputReader {
+public:
+    InputReader() = default;
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+    ~InputReader() { close(); }
+
+    // "-" reads standard input (mapped as well when it is a redirected file).
+    bool open(const string& path) {
+        close();
+        ownsFd_ = path != "-";
+        fd_ = ownsFd_ ? ::open(path.c_str(), O_RDONLY) : STDIN_FILENO;
+        if (fd_ < 0) return false;
+
+        struct stat st;
+        if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode)) {
+            eof_ = true;
+            if (st.st_size == 0) return true;
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, size_t(st.st_size), MADV_SEQUENTIAL);
+                map_ = static_cast<const char*>(p);
+                base_ = map_;
+                end_ = size_t(st.st_size);
+                STAT_ADD(bytesRead, end_);
+                return true;
+            }
+            eof_ = false;  // mapping refused: stream it instead
+        }
+        buf_.resize(BUF_SIZE);
+        base_ = buf_.data();
+        return true;
+    }
+
+    // Next n tokens, or false once the input runs out first. The views stay
+    // valid until the following call.
+    bool next(std::string_view* toks, size_t n) {
+        keep_ = pos_;  // previous tokens are released
+        for (;;) {
+            size_t p = keep_, got = 0;
+            bool more = false;
+            while (got < n) {
+                while (p < end_ && is_space(base_[p])) ++p;
+                size_t start = p;
+                while (p < end_ && !is_space(base_[p])) ++p;
+                if (p == end_ && !eof_) { more = true; break; }  // may continue past the buffer
+                if (p == start) break;
+                toks[got++] = std::string_view(base_ + start, p - start);
+            }
+            if (!more) {
+                pos_ = p;
+                return got == n;
+            }
+            refill();
+        }
+    }
+
+    // The whole input when it is a mapped file, otherwise an empty view.
+    std::string_view mapped() const {
+        return map_ ? std::string_view(map_, end_) : std::string_view();
+    }
+
+    // Up to n bytes straight from an unmapped stream, 0 at its end. For
+    // callers that split the input themselves; not to be mixed with next().
+    size_t read_raw(char* p, size_t n) {
+        for (;;) {
+            ssize_t r = ::read(fd_, p, n);
+            if (r > 0) {
+                STAT_ADD(bytesRead, size_t(r));
+                return size_t(r);
+            }
+            if (r < 0 && errno == EINTR) continue;
+            return 0;
+        }
+    }
+
+private:
+    static constexpr size_t BUF_SIZE = size_t(1) << 22;
+
+    void refill() {
+        // slide the unconsumed bytes to the front, growing only for huge tokens
+        if (keep_ > 0) {
+            std::copy(buf_.begin() + keep_, buf_.begin() + end_, buf_.begin());
+            end_ -= keep_;
+            keep_ = 0;
+        }
+        if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+        base_ = buf_.data();
+
+        for (;;) {
+            ssize_t n = ::read(fd_, buf_.data() + end_, buf_.size() - end_);
+            if (n > 0) {
+                end_ += size_t(n);
+                STAT_ADD(bytesRead, size_t(n));
+                return;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            eof_ = true;  // end of stream (or a read error)
+            return;
+        }
+    }
+
+    void close() {
+        if (map_) munmap(const_cast<char*>(map_), end_);
+        if (fd_ >= 0 && ownsFd_) ::close(fd_);
+        fd_ = -1;
+        map_ = base_ = nullptr;
+        pos_ = end_ = keep_ = 0;
+        eof_ = false;
+        buf_.clear();
+    }
+
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    const char* map_ = nullptr;   // whole-file mapping, if any
+    std::vector<char> buf_;       // streaming buffer otherwise
+    const char* base_ = nullptr;
+    size_t pos_ = 0, end_ = 0, keep_ = 0;
+    bool eof_ = false;
+};
+
+/* -------------------- Output sink -------------------- */
+/*
+   Callers format straight into buffer(); once about a megabyte has piled up
+   it goes out in a single write(2). Anything written through std::cout must
+   be flushed before the sink is used so the two streams stay in order. A
+   failed write (EPIPE, ENOSPC) drops the rest of the output and is kept
+   in error() for the caller to report.
+*/
+
+class OutputSink {
+public:
+    explicit OutputSink(int fd = STDOUT_FILENO) : fd_(fd) { buf_.reserve(FLUSH_SIZE + (FLUSH_SIZE >> 2)); }
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    ~OutputSink() { flush(); }
+
+    string& buffer() { return buf_; }
+
+    // Call after each record appended to buffer().
+    void commit() {
+        if (buf_.size() >= FLUSH_SIZE) flush();
+    }
+
+    // Large blocks bypass the buffer instead of being copied into it.
+    void write(std::string_view s) {
+        if (buf_.size() + s.size() < FLUSH_SIZE) { buf_ += s; return; }
+        flush();
+        write_all(s.data(), s.size());
+    }
+
+    void flush() {
+        write_all(buf_.data(), buf_.size());
+        buf_.clear();
+    }
+
+    // errno of the first failed write, 0 if none failed
+    int error() const { return err_; }
+
+private:
+    static constexpr size_t FLUSH_SIZE = size_t(1) << 20;
+
+    void write_all(const char* p, size_t n) {
+        STAT_LAP(lap);
+        STAT_ADD(bytesWritten, n);
+        while (n > 0 && fd_ >= 0) {
+            ssize_t w = ::write(fd_, p, n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) {  // reader went away or the disk is full: drop the rest
+                err_ = w < 0 ? errno : EIO;
+                fd_ = -1;
+                return;
+            }
+            p += w;
+            n -= size_t(w);
+        }
+        STAT_MARK(lap, writeNs);
+    }
+
+    int fd_;
+    int err_ = 0;
+    string buf_;
+};
+
+// Append the decimal digits of v.
+inline void append_uint(string& out, unsigned long long v) {
+    char buf[20];
+    size_t len = 0;
+    do { buf[len++] = char('0' + v % 10); v /= 10; } while (v);
+    while (len) out.push_back(buf[--len]);
+}
+
+/* -------------------- Result cache (--cache, --cache-file) -------------------- */
+/*
+   A bounded memo of formatted results, keyed by the exact bytes of a case
+   (op, context and both operands in canonical text, so "+0001.0" and "1"
+   share an entry). The table is set-associative open addressing: a key
+   hashes to one set of CACHE_WAYS slots, a hit refreshes the slot's stamp
+   and an insert replaces the least recently used slot of its set. A key
+   and value that do not fit in one slot are not cached. An insert clears
+   the slot's stamp before it writes and sets it last, and each slot keeps
+   a checksum of its value, so a slot left half written (a run killed
+   mid-insert, a damaged file) reads as empty rather than as a wrong answer.
+
+   With --cache-file the table is a shared mapping of that file, so a warm
+   run starts with everything the previous one computed; otherwise it is
+   anonymous memory. Sets are locked by stripe so -j workers share the one
+   table. The file is locked while mapped: a second process opening it
+   fails (with EWOULDBLOCK) instead of sharing it.
+*/
+
+constexpr size_t CACHE_SETS = 2048, CACHE_WAYS = 8, CACHE_SLOT = 512;  // 8 MiB table
+constexpr char CACHE_MAGIC[8] = {'C', 'A', 'L', 'C', 'M', 'E', 'M', '3'};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t sets, ways, slotBytes, reserved;
+    uint64_t clock;  // last stamp handed out, kept across runs
+    char pad[32];
+};
+
+struct CacheSlot {
+    uint16_t keyLen, valLen;
+    uint32_t check;             // value_check of the value
+    char data[CACHE_SLOT - 8];  // key, then value
+};
+
+// The tags come first so a probe reads two lines plus the matching slot
+struct CacheSet {
+    uint64_t hash[CACHE_WAYS];
+    uint64_t stamp[CACHE_WAYS];  // 0: empty
+    CacheSlot slot[CACHE_WAYS];
+};
+static_assert(sizeof(CacheHeader) == 64 && sizeof(CacheSlot) == CACHE_SLOT, "cache file layout");
+
+// Multiply-xorshift over 8-byte words; fixed constants keep it stable
+// across builds and runs, which a persistent table needs.
+inline uint64_t cache_hash(std::string_view s) {
+    const uint64_t k = 0x9e3779b97f4a7c15ull;
+    uint64_t h = s.size() * k;
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * k;
+        h ^= h >> 32;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, s.data() + i, s.size() - i);
+    h = (h ^ w) * k;
+    return h ^ (h >> 29);
+}
+
+inline uint32_t value_check(std::string_view value) { return uint32_t(cache_hash(value) >> 16); }
+
+class ResultCache {
+public:
+    ResultCache() = default;
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+    ~ResultCache() {
+        if (hdr_) munmap(hdr_, bytes_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    // Map the table from path (created or reset if it doesn't hold one), or
+    // from anonymous memory for an empty path. Fails with errno EWOULDBLOCK
+    // when another process holds the file.
+    bool open(const string& path) {
+        bytes_ = sizeof(CacheHeader) + CACHE_SETS * sizeof(CacheSet);
+        void* p;
+        if (path.empty()) {
+            p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        } else {
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd_ < 0 || flock(fd_, LOCK_EX | LOCK_NB) != 0) return false;
+            struct stat st;
+            if (fstat(fd_, &st) != 0) return false;
+            if (size_t(st.st_size) != bytes_ && (ftruncate(fd_, 0) != 0 || ftruncate(fd_, off_t(bytes_)) != 0))
+                return false;
+            p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        }
+        if (p == MAP_FAILED) return false;
+        hdr_ = static_cast<CacheHeader*>(p);
+        sets_ = reinterpret_cast<CacheSet*>(hdr_ + 1);
+        if (std::memcmp(hdr_->magic, CACHE_MAGIC, sizeof CACHE_MAGIC) != 0 || hdr_->sets != CACHE_SETS ||
+            hdr_->ways != CACHE_WAYS || hdr_->slotBytes != CACHE_SLOT) {
+            std::memset(p, 0, bytes_);  // new file or another layout: start empty
+            std::memcpy(hdr_->magic, CACHE_MAGIC, sizeof CACHE_MAGIC);
+            hdr_->sets = CACHE_SETS;
+            hdr_->ways = CACHE_WAYS;
+            hdr_->slotBytes = CACHE_SLOT;
+        }
+        return true;
+    }
+
+    // The value cached for key, into value.
+    bool find(std::string_view key, string& value) {
+        if (key.size() > sizeof(CacheSlot::data)) return false;
+        uint64_t h = cache_hash(key);
+        size_t set = set_of(h);
+        std::lock_guard<std::mutex> lock(locks_[set % LOCKS]);
+        CacheSet& s = sets_[set];
+        for (size_t w = 0; w < CACHE_WAYS; ++w) {
+            const CacheSlot& e = s.slot[w];
+            if (!s.stamp[w] || s.hash[w] != h) continue;
+            if (size_t(e.keyLen) + e.valLen > sizeof e.data) {
+                s.stamp[w] = 0;  // lengths from a damaged file: free the way
+                continue;
+            }
+            if (e.keyLen == key.size() && std::memcmp(e.data, key.data(), key.size()) == 0) {
+                std::string_view v(e.data + e.keyLen, e.valLen);
+                if (value_check(v) != e.check) {
+                    s.stamp[w] = 0;  // half written or damaged
+                    return false;
+                }
+                s.stamp[w] = tick();
+                value.assign(v.data(), v.size());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insert(std::string_view key, std::string_view value) {
+        if (key.size() + value.size() > sizeof(CacheSlot::data)) return;
+        uint64_t h = cache_hash(key);
+        size_t set = set_of(h);
+        std::lock_guard<std::mutex> lock(locks_[set % LOCKS]);
+        CacheSet& s = sets_[set];
+        size_t v = 0;  // an empty way, else the least recently used
+        for (size_t w = 1; w < CACHE_WAYS && s.stamp[v]; ++w)
+            if (s.stamp[w] < s.stamp[v]) v = w;
+        CacheSlot& e = s.slot[v];
+        // on the shared file a crash can stop anywhere below: the way is
+        // empty until the final stamp lands
+        __atomic_store_n(&s.stamp[v], 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        s.hash[v] = h;
+        e.keyLen = uint16_t(key.size());
+        e.valLen = uint16_t(value.size());
+        e.check = value_check(value);
+        std::memcpy(e.data, key.data(), key.size());
+        std::memcpy(e.data + key.size(), value.data(), value.size());
+        __atomic_store_n(&s.stamp[v], tick(), __ATOMIC_RELEASE);
+    }
+
+private:
+    static constexpr size_t LOCKS = 64;
+
+    static size_t set_of(uint64_t h) { return size_t(h >> 32) & (CACHE_SETS - 1); }
+    uint64_t tick() { return __atomic_add_fetch(&hdr_->clock, 1, __ATOMIC_RELAXED); }
+
+    CacheHeader* hdr_ = nullptr;
+    CacheSet* sets_ = nullptr;
+    size_t bytes_ = 0;
+    int fd_ = -1;
+    std::mutex locks_[LOCKS];
+};
+
+/* -------------------- I/O & Driver -------------------- */
+
+/*
+   Case output formats (--format):
+     human     "Case N: a + b" followed by the normalized sum or an INVALID line
+               saying which operand was rejected and why
+     sum-only  the normalized sum, or INVALID, one line per case
+     tsv       case <TAB> ok|invalid <TAB> sum, or why the case is invalid
+     binary    one record per case, all integers little-endian:
+                 u32 length of the rest of the record
+                 u8  status (0 = ok, 1 = invalid; an invalid record ends here)
+                 i8  sign (+1 / -1), i32 exponent e, u32 limb count n,
+                 n x u32 base-10^9 limbs, least significant first,
+               so the sum is sign * limbs * 10^(9 * e).
+*/
+enum class OutputFormat { Human, SumOnly, Tsv, Binary };
+
+struct PairOptions;
+struct CaseBuffers;
+
+using FixedBatchFn = void (*)(string&, const PairOptions&, long long, const std::string_view*, size_t,
+                              CaseBuffers&);
+
+// What pair mode computes for each case (--op) and how it prints it
+enum class PairOp { Add, Mul, Div };
+
+struct PairOptions {
+    OutputFormat fmt = OutputFormat::Human;
+    PairOp op = PairOp::Add;
+    DecimalContext ctx;    // results are rounded to ctx.precision
+    unsigned threads = 1;  // threads one huge addition may be split over
+    ResultCache* cache = nullptr;  // --cache / --cache-file
+    FixedBatchFn fixedBatch = nullptr;  // --scale I.F, see run_fixed_batch
+};
+
+// Which of CaseBuffers' representations holds the current case
+enum class CaseRepr { Big, Small, Text, Formatted };
+
+// Per-worker operand/result buffers, reused from case to case.
+struct CaseBuffers {
+    BigDecimal A, B, S;
+    SmallDecimal a, b, s;      // CaseRepr::Small
+    BigDecimalView va, vb, vs; // CaseRepr::Text; vs points into sumText
+    string sumText, padText;   // CaseRepr::Formatted: sumText is the result
+    string key;                // result cache key
+    CaseRepr repr = CaseRepr::Big;
+
+    explicit CaseBuffers(std::pmr::memory_resource* res = nullptr) : A(res), B(res), S(res) {}
+};
+
+// Parse, add and format one case, appending its text to out.
+void run_case(string& out, const PairOptions& opt, long long caseNo, std::string_view a, std::string_view b,
+              CaseBuffers& c);
+
+// The --scale batch adder for I.F, or null when the schema is not offered.
+FixedBatchFn fixed_batch_for(unsigned i, unsigned f);
+
+// Pair mode: each "a b" pair is one case, echoed with its normalized sum.
+void run_pairs(InputReader& in, OutputSink& sink, const PairOptions& opt);
+
+/* -------------------- Batch mode (-j N) -------------------- */
+/*
+   The mapped input is cut at line boundaries into chunks that worker threads
+   process independently; each chunk's output is written as soon as every
+   chunk before it is done, so the result is byte-identical to run_pairs.
+   Pairs are formed from the global token sequence exactly as in the serial
+   reader, so a pair may even straddle a chunk boundary: a first pass counts
+   tokens per chunk, and a chunk preceded by an odd number of tokens leaves
+   its first token to the previous chunk, which reads past its end for it.
+*/
+
+void run_pairs_parallel(std::string_view data, unsigned threads, OutputSink& sink, const PairOptions& opt);
+
+// Sum mode: every token is one term folded into a single running total.
+// Both sum modes finish with the same two lines.
+void print_total(OutputSink& sink, const BigDecimal& total, unsigned long long invalid);
+
+void run_sum(InputReader& in, BigDecimalAccumulator& total, unsigned long long& invalid);
+
+void run_sum_parallel(std::string_view data, unsigned threads, BigDecimalAccumulator& total,
+                      unsigned long long& invalid);
+
+/* -------------------- Pipelined mode (--pipeline) -------------------- */
+/*
+   Three stages on their own threads, so reading, computing and writing
+   overlap even without -j: a reader hands whole-token chunks of input to
+   the compute stage (the calling thread), which hands each chunk's
+   formatted text to a writer. Bounded single-producer/single-consumer
+   rings sit between the stages; a full ring stalls its producer, which
+   caps the memory in flight at a few chunks per ring. Streams are read
+   with read(2) into owned buffers; a mapped file is passed on as views,
+   with the reader touching each chunk's pages ahead of the compute stage.
+*/
+
+// Pair mode through the pipeline; output is byte-identical to run_pairs.
+void run_pairs_pipelined(InputReader& in, OutputSink& sink, const PairOptions& opt);
+
+// Sum mode through the pipeline's reader; there is no per-term output.
+void run_sum_pipelined(InputReader& in, BigDecimalAccumulator& total, unsigned long long& invalid);
+
+}  // namespace calc
+
+#endif  // CALC_DRIVER_H
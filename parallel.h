@@ -0,0 +1,101 @@
+// parallel_for, the scheduler behind add_into's split carry chains and
+// calc's -j workers. Internal to libbigdecimal and the driver: it is not
+// part of the library's API (bigdecimal.h).
+#ifndef BIGDECIMAL_PARALLEL_H
+#define BIGDECIMAL_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bigdecimal {
+
+/* -------------------- Work-stealing scheduler -------------------- */
+/*
+   parallel_for(n, threads, fn, weight) runs fn(0..n-1) on `threads` workers.
+   Indices are dealt out in order, each to the worker with the least weight
+   so far (weight[k], e.g. a chunk's bytes, so one giant chunk counts for
+   many small ones), and every worker walks its share from the lowest index
+   up, which keeps completion roughly in index order for ordered writers.
+   A worker that runs dry steals single indices from the far end of the
+   fullest share. A share is a lock-free deque: one 64-bit word holding
+   {next, end}, claimed by CAS at the front by its owner and at the back by
+   thieves. No work is added once the run starts, so a worker that finds
+   every share empty is done.
+*/
+
+template <class Fn>
+void parallel_for(size_t n, unsigned threads, Fn fn, const std::vector<size_t>* weight = nullptr) {
+    threads = unsigned(std::min<size_t>(threads, n));
+    if (threads <= 1) {
+        for (size_t k = 0; k < n; ++k) fn(k);
+        return;
+    }
+
+    // deal: least-loaded worker first, ties to the lower worker id
+    std::vector<std::vector<uint32_t>> share(threads);
+    using Load = std::pair<size_t, unsigned>;
+    std::priority_queue<Load, std::vector<Load>, std::greater<Load>> least;
+    for (unsigned t = 0; t < threads; ++t) least.push({0, t});
+    for (size_t k = 0; k < n; ++k) {
+        Load l = least.top();
+        least.pop();
+        share[l.second].push_back(uint32_t(k));
+        l.first += weight ? std::max<size_t>((*weight)[k], 1) : 1;
+        least.push(l);
+    }
+
+    struct alignas(64) Span {
+        std::atomic<uint64_t> v{0};  // next << 32 | end, both into the owner's share
+    };
+    std::vector<Span> span(threads);
+    for (unsigned t = 0; t < threads; ++t) span[t].v.store(share[t].size());
+    auto lo = [](uint64_t s) { return uint32_t(s >> 32); };
+    auto hi = [](uint64_t s) { return uint32_t(s); };
+    auto pack = [](uint64_t l, uint64_t h) { return l << 32 | h; };
+
+    auto take_own = [&](unsigned t, size_t& k) {
+        uint64_t s = span[t].v.load(std::memory_order_acquire);
+        while (lo(s) < hi(s)) {
+            if (span[t].v.compare_exchange_weak(s, pack(lo(s) + 1, hi(s)), std::memory_order_acq_rel)) {
+                k = share[t][lo(s)];
+                return true;
+            }
+        }
+        return false;
+    };
+    auto steal = [&](size_t& k) {
+        for (;;) {
+            unsigned victim = threads;
+            uint32_t most = 0;
+            uint64_t seen = 0;
+            for (unsigned t = 0; t < threads; ++t) {
+                uint64_t s = span[t].v.load(std::memory_order_acquire);
+                if (hi(s) - lo(s) > most) { most = hi(s) - lo(s); victim = t; seen = s; }
+            }
+            if (victim == threads) return false;
+            if (span[victim].v.compare_exchange_strong(seen, pack(lo(seen), hi(seen) - 1), std::memory_order_acq_rel)) {
+                k = share[victim][hi(seen) - 1];
+                return true;
+            }
+        }
+    };
+    auto worker = [&](unsigned t) {
+        for (size_t k; take_own(t, k) || steal(k);) fn(k);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+}
+
+}  // namespace bigdecimal
+
+#endif  // BIGDECIMAL_PARALLEL_H